@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "capture.h"
+#include "../platform/timer.h"
+#include <stddef.h>
+
+#define CAPTURE_MASK (MBED_CONF_SE050_CAPTURE_SIZE - 1)
+
+#if (MBED_CONF_SE050_CAPTURE_SIZE & CAPTURE_MASK) != 0
+#error "MBED_CONF_SE050_CAPTURE_SIZE must be a power of two"
+#endif
+
+static uint8_t capture_ring[MBED_CONF_SE050_CAPTURE_SIZE];
+static uint32_t capture_head = 0; /* written by the driver */
+static uint32_t capture_tail = 0; /* written by the reader */
+static uint32_t capture_drops = 0;
+static se050_captureSink_t capture_sink = NULL;
+static void *capture_sink_arg = NULL;
+
+static void capture_put(uint32_t pos, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t k = 0; k < len; k++)
+    {
+        capture_ring[(pos + k) & CAPTURE_MASK] = data[k];
+    }
+}
+
+void se050_capture_frame(se050_captureDir_t dir, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[SE050_CAPTURE_RECORD_HDR_LEN];
+    uint32_t timestamp = se050_timer_us();
+    uint32_t head, tail;
+
+    hdr[0] = timestamp & 0xFF;
+    hdr[1] = (timestamp >> 8) & 0xFF;
+    hdr[2] = (timestamp >> 16) & 0xFF;
+    hdr[3] = (timestamp >> 24) & 0xFF;
+    hdr[4] = dir;
+    hdr[5] = 0;
+    hdr[6] = len & 0xFF;
+    hdr[7] = (len >> 8) & 0xFF;
+
+    if (capture_sink != NULL)
+    {
+        capture_sink(hdr, SE050_CAPTURE_RECORD_HDR_LEN, capture_sink_arg);
+        capture_sink(data, len, capture_sink_arg);
+        return;
+    }
+
+    head = capture_head;
+    tail = __atomic_load_n(&capture_tail, __ATOMIC_ACQUIRE);
+    if (MBED_CONF_SE050_CAPTURE_SIZE - (head - tail) < SE050_CAPTURE_RECORD_HDR_LEN + len)
+    {
+        capture_drops++;
+        return;
+    }
+    capture_put(head, hdr, SE050_CAPTURE_RECORD_HDR_LEN);
+    capture_put(head + SE050_CAPTURE_RECORD_HDR_LEN, data, len);
+    __atomic_store_n(&capture_head, head + SE050_CAPTURE_RECORD_HDR_LEN + len, __ATOMIC_RELEASE);
+}
+
+void se050_capture_setSink(se050_captureSink_t sink, void *arg)
+{
+    capture_sink = sink;
+    capture_sink_arg = arg;
+}
+
+void se050_capture_fileHeader(uint8_t *hdr)
+{
+    hdr[0] = 'S';
+    hdr[1] = '0';
+    hdr[2] = '5';
+    hdr[3] = 'C';
+    hdr[4] = SE050_CAPTURE_VERSION;
+    hdr[5] = 0;
+    hdr[6] = 0;
+    hdr[7] = 0;
+}
+
+uint32_t se050_capture_read(uint8_t *buf, uint32_t max)
+{
+    uint32_t head = __atomic_load_n(&capture_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = capture_tail;
+    uint32_t n = head - tail;
+
+    if (n > max)
+    {
+        n = max;
+    }
+    for (uint32_t k = 0; k < n; k++)
+    {
+        buf[k] = capture_ring[(tail + k) & CAPTURE_MASK];
+    }
+    __atomic_store_n(&capture_tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+uint32_t se050_capture_dropped(void)
+{
+    return capture_drops;
+}
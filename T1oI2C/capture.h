@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include <stdint.h>
+
+/*
+ * Binary capture of raw T=1 frames. Each frame written to or read from the
+ * SE050 is stored with a time stamp and its direction, either in a ring
+ * buffer drained with se050_capture_read or passed to a sink set with
+ * se050_capture_setSink (e.g. writing to a file or to flash). Capture is
+ * compiled out unless MBED_CONF_SE050_CAPTURE is set.
+ *
+ * Capture file format, all integers little endian:
+ *   file header: "S05C" | version (1 byte) | 3 reserved bytes
+ *   record:      time stamp in us (4 bytes) | direction (1 byte) |
+ *                reserved (1 byte) | frame length (2 bytes) | frame
+ * A capture file is the file header followed by the bytes returned by
+ * se050_capture_read or given to the sink. tools/replay replays it.
+ */
+
+#ifndef MBED_CONF_SE050_CAPTURE
+#define MBED_CONF_SE050_CAPTURE 0
+#endif
+
+/* Size of the ring buffer in bytes, must be a power of two */
+#ifndef MBED_CONF_SE050_CAPTURE_SIZE
+#define MBED_CONF_SE050_CAPTURE_SIZE 2048
+#endif
+
+#define SE050_CAPTURE_VERSION       1
+#define SE050_CAPTURE_FILE_HDR_LEN  8
+#define SE050_CAPTURE_RECORD_HDR_LEN 8
+
+#if defined(__cplusplus)
+extern "C"{
+#endif
+
+typedef enum
+{
+    SE050_CAPTURE_TX = 0, /* host to SE050 */
+    SE050_CAPTURE_RX = 1  /* SE050 to host */
+} se050_captureDir_t;
+
+/* Receives the bytes of the record stream: each record in two calls, header then frame */
+typedef void (*se050_captureSink_t)(const uint8_t *record, uint32_t len, void *arg);
+
+#if MBED_CONF_SE050_CAPTURE
+#define SE050_CAPTURE(dir, data, len) se050_capture_frame((dir), (data), (len))
+#else
+#define SE050_CAPTURE(dir, data, len) do {} while(0)
+#endif
+
+/* Record a frame */
+void se050_capture_frame(se050_captureDir_t dir, const uint8_t *data, uint32_t len);
+
+/* Send records to sink instead of the ring buffer, NULL to use the ring buffer */
+void se050_capture_setSink(se050_captureSink_t sink, void *arg);
+
+/* Write the capture file header in hdr (SE050_CAPTURE_FILE_HDR_LEN bytes) */
+void se050_capture_fileHeader(uint8_t *hdr);
+
+/*
+ * Move up to max bytes of the record stream from the ring buffer to buf.
+ * Returns the number of copied bytes. Single reader, may run concurrently
+ * with the driver.
+ */
+uint32_t se050_capture_read(uint8_t *buf, uint32_t max);
+
+/* Number of records dropped because the ring buffer was full */
+uint32_t se050_capture_dropped(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif //__CAPTURE_H__
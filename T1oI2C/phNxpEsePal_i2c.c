@@ -25,6 +25,7 @@
 #include <phNxpEsePal_i2c.h>
 #include <phEseStatus.h>
 #include "log.h"
+#include "trace.h"
 #include <time.h>
 #include "../platform/i2c.h"
 
@@ -133,11 +134,13 @@ int phPalEse_i2c_read(void *pDevHandle, uint8_t * pBuffer, int nNbBytesToRead)
                 LOG_D("_i2c_read() failed. Going to retry, counter:%d  !", retryCount);
                 continue;
             }
+            SE050_TRACE(SE050_TRACE_I2C_READ, 0);
             return -1;
         }
         else
         {
             numRead = nNbBytesToRead;
+            SE050_TRACE(SE050_TRACE_I2C_READ, numRead | (retryCount << 16));
             break;
         }
         LOG_D("Read Returned = %d ", ret);
@@ -185,11 +188,13 @@ int phPalEse_i2c_write(void *pDevHandle, uint8_t * pBuffer, int nNbBytesToWrite)
                 LOG_D("_i2c_write() failed. Going to retry, counter:%d  !", retryCount);
                 continue;
             }
+            SE050_TRACE(SE050_TRACE_I2C_WRITE, 0);
             return -1;
         }
         else
         {
             numWrote= nNbBytesToWrite;
+            SE050_TRACE(SE050_TRACE_I2C_WRITE, numWrote | (retryCount << 16));
             //wait_ms(ESE_POLL_DELAY_MS);
             break;
         }
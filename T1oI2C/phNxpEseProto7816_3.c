@@ -17,6 +17,7 @@
 #include <phNxpEsePal_i2c.h>
 #include <phEseTypes.h>
 #include "log.h"
+#include "trace.h"
 
 /**
  * \addtogroup ISO7816-3_protocol_lib
@@ -228,6 +229,7 @@ static bool_t phNxpEseProto7816_SendSFrame(sFrameInfo_t sFrameData)
 
             pcb_byte |= PH_PROTO_7816_S_BLOCK_REQ; /* PCB */
             pcb_byte |= PH_PROTO_7816_S_RESYNCH;
+            nxpese_stats.resyncs++;
             break;
 #if defined(T1oI2C_UM1225_SE050)
         case INTF_RESET_REQ:
@@ -237,6 +239,7 @@ static bool_t phNxpEseProto7816_SendSFrame(sFrameInfo_t sFrameData)
 
             pcb_byte |= PH_PROTO_7816_S_BLOCK_REQ; /* PCB */
             pcb_byte |= PH_PROTO_7816_S_RESET;
+            nxpese_stats.intfResets++;
             break;
         case PROP_END_APDU_REQ:
             frame_len = (PH_PROTO_7816_HEADER_LEN + PH_PROTO_7816_CRC_LEN);
@@ -351,6 +354,8 @@ static  bool_t phNxpEseProto7816_sendRframe(rFrameTypes_t rFrameType)
     uint16_t calc_crc=0;
     if(RNACK == rFrameType) /* R-NACK */
     {
+        SE050_TRACE(SE050_TRACE_RNACK, phNxpEseProto7816_3_Var.phNxpEseNextTx_Cntx.RframeInfo.errCode);
+        nxpese_stats.rnackSent++;
         recv_ack[PH_PROPTO_7816_PCB_OFFSET] = 0x82;
     }
     else /* R-ACK*/
@@ -391,6 +396,7 @@ static bool_t phNxpEseProto7816_SendIframe(iFrameInfo_t iFrameData)
         LOG_E("%s Line: [%d] I frame Len is 0, INVALID ",__FUNCTION__,__LINE__);
         return FALSE;
     }
+    SE050_TRACE(SE050_TRACE_IFRAME_SEND, iFrameData.sendDataLen);
     /* This update is helpful in-case a R-NACK is transmitted from the MW */
     phNxpEseProto7816_3_Var.lastSentNonErrorframeType = IFRAME;
     frame_len = (iFrameData.sendDataLen+ PH_PROTO_7816_HEADER_LEN + PH_PROTO_7816_CRC_LEN);
@@ -733,6 +739,7 @@ static bool_t phNxpEseProto7816_DecodeFrame(uint8_t *p_data, uint32_t data_len)
             ((pcb_bits.lsb == 0x00) && (pcb_bits.bit2 == 0x01)))
         {
             wait_ms(DELAY_ERROR_RECOVERY/1000);
+            nxpese_stats.rnackReceived++;
             if((pcb_bits.lsb == 0x00) && (pcb_bits.bit2 == 0x01))
                 phNxpEseProto7816_3_Var.phNxpEseRx_Cntx.lastRcvdRframeInfo.errCode = OTHER_ERROR;
             else
@@ -746,6 +753,7 @@ static bool_t phNxpEseProto7816_DecodeFrame(uint8_t *p_data, uint32_t data_len)
                             sizeof(phNxpEseProto7816_NextTx_Info_t));
                     phNxpEseProto7816_3_Var.phNxpEseProto7816_nextTransceiveState = SEND_IFRAME;
                     phNxpEseProto7816_3_Var.phNxpEseNextTx_Cntx.FrameType = IFRAME;
+                    nxpese_stats.retransmissions++;
                 }
                 else if(phNxpEseProto7816_3_Var.phNxpEseLastTx_Cntx.FrameType == RFRAME)
                 {
@@ -761,6 +769,7 @@ static bool_t phNxpEseProto7816_DecodeFrame(uint8_t *p_data, uint32_t data_len)
                             sizeof(phNxpEseProto7816_NextTx_Info_t));
                         phNxpEseProto7816_3_Var.phNxpEseProto7816_nextTransceiveState = SEND_IFRAME;
                         phNxpEseProto7816_3_Var.phNxpEseNextTx_Cntx.FrameType = IFRAME;
+                        nxpese_stats.retransmissions++;
                     }
                     /* Usecase to reach the below case:
                     R-frame sent first, followed by R-NACK and we receive a R-NACK with
@@ -844,6 +853,12 @@ static bool_t phNxpEseProto7816_DecodeFrame(uint8_t *p_data, uint32_t data_len)
                 break;
             case WTX_REQ:
                 phNxpEseProto7816_3_Var.wtx_counter++;
+                SE050_TRACE(SE050_TRACE_WTX, phNxpEseProto7816_3_Var.wtx_counter);
+                nxpese_stats.wtx++;
+                if(phNxpEseProto7816_3_Var.wtx_counter > nxpese_stats.wtxMax)
+                {
+                    nxpese_stats.wtxMax = phNxpEseProto7816_3_Var.wtx_counter;
+                }
                 LOG_D("%s Wtx_counter value - %lu ", __FUNCTION__, phNxpEseProto7816_3_Var.wtx_counter);
                 LOG_D("%s Wtx_counter wtx_counter_limit - %lu ", __FUNCTION__, phNxpEseProto7816_3_Var.wtx_counter_limit);
                 /* Previous sent frame is some S-frame but not WTX response S-frame */
@@ -1013,6 +1028,8 @@ static bool_t phNxpEseProto7816_ProcessResponse(void)
         else
         {
             LOG_E("%s CRC Check failed ", __FUNCTION__);
+            SE050_TRACE(SE050_TRACE_CRC_ERROR, data_len);
+            nxpese_stats.crcErrors++;
             if(phNxpEseProto7816_3_Var.rnack_retry_counter < phNxpEseProto7816_3_Var.rnack_retry_limit)
             {
                 phNxpEseProto7816_3_Var.phNxpEseRx_Cntx.lastRcvdFrameType = INVALID ;
@@ -18,6 +18,8 @@
 #include <phNxpEseProto7816_3.h>
 #include <phNxpEsePal_i2c.h>
 #include "log.h"
+#include "trace.h"
+#include "capture.h"
 #include "string.h"
 #include "mbed_thread.h"
 
@@ -26,12 +28,17 @@
 #define CHAINED_PACKET_WITHOUTSEQN      0x20
 static int phNxpEse_readPacket(void *pDevHandle, uint8_t * pBuffer, int nNbBytesToRead);
 static int poll_sof_chained_delay = 0;
+static phNxpEse_pollHook_t poll_hook = NULL;
+static void *poll_hook_arg = NULL;
 
 /*********************** Global Variables *************************************/
 
 /* ESE Context structure */
 phNxpEse_Context_t nxpese_ctxt;
 
+/* Protocol statistics */
+phNxpEse_stats_t nxpese_stats;
+
 /******************************************************************************
  * Function         phNxpEse_init
  *
@@ -163,6 +170,7 @@ ESESTATUS phNxpEse_Transceive( phNxpEse_data *pCmd, phNxpEse_data *pRsp)
     else
     {
         nxpese_ctxt.EseLibStatus = ESE_STATUS_BUSY;
+        nxpese_stats.apdus++;
         bStatus = phNxpEseProto7816_Transceive(pCmd, pRsp);
         if(TRUE == bStatus)
         {
@@ -170,6 +178,7 @@ ESESTATUS phNxpEse_Transceive( phNxpEse_data *pCmd, phNxpEse_data *pRsp)
         }
         else
         {
+            nxpese_stats.apduFailures++;
             status = ESESTATUS_FAILED;
         }
 
@@ -228,6 +237,56 @@ ESESTATUS phNxpEse_EndOfApdu(void)
     return status;
 }
 
+/******************************************************************************
+ * Function         phNxpEse_setPollHook
+ *
+ * Description      This function sets a hook called while the ESE is busy,
+ *                  before each polling delay of a frame read. The hook must
+ *                  not call any function of this library. When the hook
+ *                  did some work, the ESE is polled again without delay as
+ *                  the work already took its share of the processing time.
+ *
+ * param[in]        phNxpEse_pollHook_t: hook, NULL to remove it
+ * param[in]        void: argument of the hook
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void phNxpEse_setPollHook(phNxpEse_pollHook_t hook, void *arg)
+{
+    poll_hook = hook;
+    poll_hook_arg = arg;
+}
+
+/******************************************************************************
+ * Function         phNxpEse_getStats
+ *
+ * Description      This function copies the protocol statistics.
+ *
+ * param[out]       phNxpEse_stats_t: statistics
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void phNxpEse_getStats(phNxpEse_stats_t *stats)
+{
+    phNxpEse_memcpy(stats, &nxpese_stats, sizeof(phNxpEse_stats_t));
+}
+
+/******************************************************************************
+ * Function         phNxpEse_resetStats
+ *
+ * Description      This function clears the protocol statistics.
+ *
+ * param[in]        void
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void phNxpEse_resetStats(void)
+{
+    phNxpEse_memset(&nxpese_stats, 0x00, sizeof(phNxpEse_stats_t));
+}
 
 /******************************************************************************
  * Function         phNxpEse_chipReset
@@ -379,6 +438,9 @@ ESESTATUS phNxpEse_read(uint32_t *data_len, uint8_t **pp_data)
     else
     {
         //LOG_MAU8_D("RAW Rx<",nxpese_ctxt.p_read_buff,ret );
+        SE050_CAPTURE(SE050_CAPTURE_RX, nxpese_ctxt.p_read_buff, ret);
+        nxpese_stats.framesReceived++;
+        nxpese_stats.bytesReceived += ret;
         *data_len = ret;
         *pp_data = nxpese_ctxt.p_read_buff;
         status = ESESTATUS_SUCCESS;
@@ -479,6 +541,11 @@ static int phNxpEse_readPacket(void *pDevHandle, uint8_t * pBuffer, int nNbBytes
             }
             break;
         }
+        /*Let the host work while the ESE is busy*/
+        if((poll_hook != NULL) && (poll_hook(poll_hook_arg) != 0))
+        {
+            continue;
+        }
         /*If it is Chained packet wait for 1 ms*/
         if(poll_sof_chained_delay == 1)
         {
@@ -491,6 +558,12 @@ static int phNxpEse_readPacket(void *pDevHandle, uint8_t * pBuffer, int nNbBytes
             thread_sleep_for(ESE_POLL_DELAY_MS);
         }
     } while ((sof_counter < ESE_NAD_POLLING_MAX) && (nxpese_ctxt.EseLibStatus!= ESE_STATUS_CLOSE));
+    SE050_TRACE(SE050_TRACE_NAD_POLL, sof_counter);
+    nxpese_stats.nadPolls += sof_counter;
+    if(sof_counter > (int)nxpese_stats.nadPollsMax)
+    {
+        nxpese_stats.nadPollsMax = sof_counter;
+    }
     if((pBuffer[0] == RECIEVE_PACKET_SOF) && (ret > 0))
     {
         LOG_D("%s SOF FOUND", __FUNCTION__);
@@ -576,6 +649,9 @@ ESESTATUS phNxpEse_WriteFrame(uint32_t data_len, const uint8_t *p_data)
         else
         {
             status = ESESTATUS_SUCCESS;
+            SE050_CAPTURE(SE050_CAPTURE_TX, nxpese_ctxt.p_cmd_data, nxpese_ctxt.cmd_len);
+            nxpese_stats.framesSent++;
+            nxpese_stats.bytesSent += data_len;
             //LOG_MAU8_D("RAW Tx>",nxpese_ctxt.p_cmd_data, nxpese_ctxt.cmd_len );
         }
     }
@@ -52,6 +52,35 @@ typedef struct phNxpEse_initParams
     phNxpEse_initMode initMode; /*!< Ese communication mode */
 } phNxpEse_initParams;
 
+/**
+ * \brief Protocol statistics. Counters are kept across open/close and
+ * protocol resets, they are only cleared by phNxpEse_resetStats.
+ */
+typedef struct phNxpEse_stats
+{
+    uint32_t apdus; /*!< APDUs exchanged */
+    uint32_t apduFailures; /*!< APDUs failed at protocol level */
+    uint32_t framesSent; /*!< frames written */
+    uint32_t framesReceived; /*!< frames read */
+    uint64_t bytesSent; /*!< frame bytes written */
+    uint64_t bytesReceived; /*!< frame bytes read */
+    uint32_t retransmissions; /*!< I-frames sent again after a R-NACK */
+    uint32_t rnackSent; /*!< R-NACK frames sent */
+    uint32_t rnackReceived; /*!< R-NACK frames received */
+    uint32_t crcErrors; /*!< frames received with a wrong CRC */
+    uint32_t wtx; /*!< WTX requests received */
+    uint32_t wtxMax; /*!< maximum WTX requests received during one APDU */
+    uint32_t resyncs; /*!< RESYNCH requests sent */
+    uint32_t intfResets; /*!< interface reset requests sent */
+    uint32_t nadPolls; /*!< NAD polls before frame start, summed over received frames */
+    uint32_t nadPollsMax; /*!< maximum NAD polls before the start of a frame */
+} phNxpEse_stats_t;
+
+/**
+ * \brief Hook called while the ESE is busy, see phNxpEse_setPollHook.
+ * Returns non-zero if it did some work, zero if it had nothing to do.
+ */
+typedef int (*phNxpEse_pollHook_t)(void *arg);
 
 ESESTATUS phNxpEse_init(phNxpEse_initParams initParams, phNxpEse_data *AtrRsp);
 ESESTATUS phNxpEse_open(phNxpEse_initParams initParams);
@@ -62,6 +91,9 @@ ESESTATUS phNxpEse_reset(void);
 ESESTATUS phNxpEse_chipReset(void);
 ESESTATUS phNxpEse_setIfsc(uint16_t IFSC_Size);
 ESESTATUS phNxpEse_EndOfApdu(void);
+void phNxpEse_setPollHook(phNxpEse_pollHook_t hook, void *arg);
+void phNxpEse_getStats(phNxpEse_stats_t *stats);
+void phNxpEse_resetStats(void);
 void* phNxpEse_memset(void *buff, int val, size_t len);
 void* phNxpEse_memcpy(void *dest, const void *src, size_t len);
 void *phNxpEse_memalloc(uint32_t size);
@@ -45,6 +45,9 @@ typedef struct phNxpEse_Context
 } phNxpEse_Context_t;
 
 
+/* Protocol statistics, not cleared with the ESE context */
+extern phNxpEse_stats_t nxpese_stats;
+
 ESESTATUS phNxpEse_WriteFrame(uint32_t data_len, const uint8_t *p_data);
 ESESTATUS phNxpEse_read(uint32_t *data_len, uint8_t **pp_data);
 void phNxpEse_clearReadBuffer(void);
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.h"
+#include "../platform/timer.h"
+
+#ifndef SE050_TRACE_TIMESTAMP
+#define SE050_TRACE_TIMESTAMP() se050_timer_us()
+#endif
+
+#define TRACE_MASK (MBED_CONF_SE050_TRACE_DEPTH - 1)
+
+#if (MBED_CONF_SE050_TRACE_DEPTH & TRACE_MASK) != 0
+#error "MBED_CONF_SE050_TRACE_DEPTH must be a power of two"
+#endif
+
+static se050_traceRecord_t trace_ring[MBED_CONF_SE050_TRACE_DEPTH];
+static uint32_t trace_head = 0;
+
+static const char * const trace_names[SE050_TRACE_EVENTS] = {
+    "APDU_START", "APDU_END", "IFRAME_SEND", "NAD_POLL", "WTX", "RNACK",
+    "CRC_ERROR", "I2C_WRITE", "I2C_READ"
+};
+
+void se050_trace_record(se050_traceEvent_t event, uint32_t value)
+{
+    uint32_t seq = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+    se050_traceRecord_t *record = &trace_ring[seq & TRACE_MASK];
+
+    /* invalidate the record while it is written */
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record->timestamp = SE050_TRACE_TIMESTAMP();
+    record->event = event;
+    record->value = value;
+    __atomic_store_n(&record->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t se050_trace_read(uint32_t *cursor, se050_traceRecord_t *records,
+        uint32_t max, uint32_t *lost)
+{
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+    uint32_t n = 0;
+
+    *lost = 0;
+    if (head - *cursor > MBED_CONF_SE050_TRACE_DEPTH)
+    {
+        *lost = head - *cursor - MBED_CONF_SE050_TRACE_DEPTH;
+        *cursor = head - MBED_CONF_SE050_TRACE_DEPTH;
+    }
+    while ((*cursor != head) && (n < max))
+    {
+        const se050_traceRecord_t *record = &trace_ring[*cursor & TRACE_MASK];
+        uint32_t seq = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+
+        /* record still being written, read it next time */
+        if ((seq == 0) || (seq < *cursor + 1))
+        {
+            break;
+        }
+        records[n].timestamp = record->timestamp;
+        records[n].event = record->event;
+        records[n].value = record->value;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        /* keep the copy only if the record was not rewritten meanwhile */
+        if ((seq == *cursor + 1) && (__atomic_load_n(&record->seq, __ATOMIC_RELAXED) == seq))
+        {
+            records[n].seq = seq;
+            n++;
+        }
+        else
+        {
+            (*lost)++;
+        }
+        (*cursor)++;
+    }
+    return n;
+}
+
+const char *se050_trace_eventName(uint32_t event)
+{
+    return (event < SE050_TRACE_EVENTS) ? trace_names[event] : "?";
+}
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+/*
+ * Low overhead event trace of the protocol layers. Events are time stamped
+ * and stored in a ring buffer which can be read while the driver runs.
+ * Tracing is compiled out unless MBED_CONF_SE050_TRACE is set. The time
+ * stamp source defaults to se050_timer_us() and can be replaced by defining
+ * SE050_TRACE_TIMESTAMP(), e.g. with a cycle counter.
+ */
+
+#ifndef MBED_CONF_SE050_TRACE
+#define MBED_CONF_SE050_TRACE 0
+#endif
+
+/* Number of records of the ring buffer, must be a power of two */
+#ifndef MBED_CONF_SE050_TRACE_DEPTH
+#define MBED_CONF_SE050_TRACE_DEPTH 128
+#endif
+
+#if defined(__cplusplus)
+extern "C"{
+#endif
+
+typedef enum
+{
+    SE050_TRACE_APDU_START = 0, /* value: command length */
+    SE050_TRACE_APDU_END,       /* value: status word, 0 on failure */
+    SE050_TRACE_IFRAME_SEND,    /* value: information field length */
+    SE050_TRACE_NAD_POLL,       /* value: number of polls before the frame start */
+    SE050_TRACE_WTX,            /* value: WTX requests received for the current APDU */
+    SE050_TRACE_RNACK,          /* value: error code of the sent R-NACK */
+    SE050_TRACE_CRC_ERROR,      /* value: length of the received frame */
+    SE050_TRACE_I2C_WRITE,      /* value: length | NACK retries << 16, 0 on failure */
+    SE050_TRACE_I2C_READ,       /* value: length | NACK retries << 16, 0 on failure */
+    SE050_TRACE_EVENTS
+} se050_traceEvent_t;
+
+typedef struct
+{
+    uint32_t seq;       /* sequence number + 1, written last */
+    uint32_t timestamp;
+    uint32_t event;
+    uint32_t value;
+} se050_traceRecord_t;
+
+#if MBED_CONF_SE050_TRACE
+#define SE050_TRACE(event, value) se050_trace_record((event), (value))
+#else
+#define SE050_TRACE(event, value) do {} while(0)
+#endif
+
+/* Record an event. Safe to call concurrently with se050_trace_read. */
+void se050_trace_record(se050_traceEvent_t event, uint32_t value);
+
+/*
+ * Copy records from *cursor (a sequence number, 0 at start) on into records.
+ * Records overwritten since the last call are skipped and counted in *lost.
+ * Returns the number of copied records, *cursor is moved past them.
+ */
+uint32_t se050_trace_read(uint32_t *cursor, se050_traceRecord_t *records,
+        uint32_t max, uint32_t *lost);
+
+/* Name of an event, for dumps */
+const char *se050_trace_eventName(uint32_t event);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif //__TRACE_H__
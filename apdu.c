@@ -16,129 +16,85 @@
  */
 
 #include "apdu.h"
+#include "apdu_internal.h"
+#include "se050_tlv.h"
+#include "se050_powerlog.h"
+#include "T1oI2C/trace.h"
 #include <string.h>
 
-#define CHECK_IF_ERROR_AND_ACCUMULATE(tmp, acc) if(tmp > 0) {\
-													acc += tmp;\
-												} else {\
-													return APDU_ERROR;\
-												}
-
 #define CHECK_IF_ERROR(a)	if(a != APDU_OK) {\
 								return APDU_ERROR;\
 							}
 
-static uint32_t setTLVU8(SE050_TAG_t tag, uint8_t *buff, uint8_t value, bool extended) {
-
-	uint32_t i = 0;
-	buff[i++] = tag;
-	if (extended)
-		buff[i++] = 0x00;
-	buff[i++] = 0x01;
-	buff[i++] = value;
-
-	return i;
-}
-
-static uint32_t setTLVU16(SE050_TAG_t tag, uint8_t *buff, uint16_t value,
-		bool extended) {
-
-	uint32_t i = 0;
-	buff[i++] = tag;
-	if (extended)
-		buff[i++] = 0x00;
-	buff[i++] = 0x02;
-	buff[i++] = (value & 0xFF00) >> 8;
-	buff[i++] = value & 0x00FF;
-
-	return i;
-}
-
-static uint32_t setTLVU32(SE050_TAG_t tag, uint8_t *buff, uint32_t value,
-		bool extended) {
-
-	uint32_t i = 0;
-	buff[i++] = tag;
-	if (extended)
-		buff[i++] = 0x00;
-	buff[i++] = 0x04;
-	buff[i++] = (value & 0xFF000000) >> 24;
-	buff[i++] = (value & 0x00FF0000) >> 16;
-	buff[i++] = (value & 0x0000FF00) >> 8;
-	buff[i++] = (value & 0x000000FF);
+#ifndef MBED_CONF_SE050_MAC_CRYPTO_OBJ_ID
+#define MBED_CONF_SE050_MAC_CRYPTO_OBJ_ID 0x0001
+#endif
 
-	return i;
-}
-
-//TODO: extended array 0x82?
-static uint32_t setTLVarray(SE050_TAG_t tag, uint8_t *buff, const uint8_t *array,
-		uint32_t len, bool extended) {
-
-	uint32_t i = 0;
-
-	//first move data to prevent overwriting
-	i += (extended) ? 3 : 2;
-	memmove(&buff[i], &array[0], len);
-
-	//then set tag and length
-	i = 0;
-	buff[i++] = tag;
-	if (extended)
-		buff[i++] = (len & 0x0000FF00) >> 8;
-	buff[i++] = (len & 0x000000FF);
-
-	return i + len;
-}
-
-static uint32_t getTLVarray(SE050_TAG_t tag, uint8_t *buff, uint8_t *array[],
-		uint32_t *len, bool extended) {
-
-	if (tag != buff[0])
-		return 0;
+/*
+ * Compute the exact length of the encoded I2CM commands and an upper bound of
+ * the length of their responses (reads are assumed to return all requested
+ * bytes). Returns false if a tag is unknown.
+ */
+static bool getI2CMSizes(const i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		uint32_t *cmdsLen, uint32_t *rspsLen) {
 
-	if (buff[1] == 0x82) { //extended
-		*len = buff[2] << 8 | buff[3];
-		*array = &buff[4];
-		return *len + 4;
-	} else {
-		*len = buff[1];
-		*array = &buff[2];
-		return *len + 2;
+	for (int k = 0; k < sz_tlv; k++) {
+		switch (tlv[k].tag) {
+		case SE050_TAG_I2CM_Config:
+			*cmdsLen += 3 + 2;
+			*rspsLen += 2;
+			break;
+		case SE050_TAG_I2CM_Write:
+			*cmdsLen += 3 + tlv[k].cmd.len;
+			*rspsLen += 2;
+			break;
+		case SE050_TAG_I2CM_Read:
+			*cmdsLen += 3 + 2;
+			*rspsLen += 4 + tlv[k].cmd.len;
+			break;
+		default:
+			return false;
+		}
 	}
+	return true;
 }
 
-static uint32_t setI2CMCmds(i2cm_tlv_t *tlv, uint8_t sz_tlv,
-		phNxpEse_data *payload) {
+static void setI2CMCmds(const i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		se050_tlvWriter_t *w) {
 
-	uint32_t i = 0;
 	for (int k = 0; k < sz_tlv; k++) {
 		switch (tlv[k].tag) {
 		case SE050_TAG_I2CM_Config:
-			i += setTLVarray(tlv[k].tag, &payload->p_data[i],
-					&tlv[k].cmd.p_data[0], 2, true);
+			se050_tlv_putHeader(w, tlv[k].tag, 2, true);
+			se050_tlv_putRaw(w, &tlv[k].cmd.p_data[0], 2);
 			break;
 		case SE050_TAG_I2CM_Write:
-			i += setTLVarray(tlv[k].tag, &payload->p_data[i],
-					&tlv[k].cmd.p_data[0], tlv[k].cmd.len, true);
+			se050_tlv_putHeader(w, tlv[k].tag, tlv[k].cmd.len, true);
+			se050_tlv_putRaw(w, &tlv[k].cmd.p_data[0], tlv[k].cmd.len);
 			break;
-		case SE050_TAG_I2CM_Read:
-			i += setTLVU16(tlv[k].tag, &payload->p_data[i],
-					tlv[k].cmd.len & 0x0000FFFF, true);
+		case SE050_TAG_I2CM_Read: {
+			const uint8_t len[] = { (tlv[k].cmd.len & 0xFF00) >> 8,
+					tlv[k].cmd.len & 0x00FF };
+			se050_tlv_putHeader(w, tlv[k].tag, 2, true);
+			se050_tlv_putRaw(w, &len[0], 2);
 			break;
+		}
 		default:
-			return -1;
+			w->overflow = true;
+			return;
 		}
 	}
-	return i;
 }
 
-static int32_t getI2CMRsps(i2cm_tlv_t *tlv, uint8_t sz_tlv,
-		phNxpEse_data *payload) {
+apdu_status_t se050_i2cm_getRsps(i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		const phNxpEse_data *payload, uint32_t *offset) {
 
-	uint32_t i = 0;
+	uint32_t i = *offset;
 	uint8_t tag;
 	uint16_t len;
 	for (int k = 0; k < sz_tlv; k++) {
+		if (i + 2 > payload->len)
+			return APDU_ERROR;
 		tag = payload->p_data[i++];
 		if (tag != tlv[k].tag)
 			return APDU_ERROR;
@@ -148,8 +104,12 @@ static int32_t getI2CMRsps(i2cm_tlv_t *tlv, uint8_t sz_tlv,
 		case SE050_TAG_I2CM_Write:
 			break;
 		case SE050_TAG_I2CM_Read:
+			if (i + 2 > payload->len)
+				return APDU_ERROR;
 			len = payload->p_data[i++] << 8;
 			len |= payload->p_data[i++];
+			if (i + len > payload->len)
+				return APDU_ERROR;
 			tlv[k].rsp.len = len;
 			tlv[k].rsp.p_data = &payload->p_data[i];
 			i += len;
@@ -158,34 +118,211 @@ static int32_t getI2CMRsps(i2cm_tlv_t *tlv, uint8_t sz_tlv,
 			return APDU_ERROR;
 		}
 	}
+	*offset = i;
 	return APDU_OK;
 }
 
-// does not support extend command
-static apdu_status_t APDU_case4(const uint8_t *header, apdu_ctx_t *ctx) {
-	ESESTATUS status = ESESTATUS_OK;
+/*
+ * Write the APDU header just before command data and append Le. Command data
+ * (ctx->in.len bytes) are expected at APDU_HDR_MAX_SZ in buff, so
+ * that the header is written in place without moving them.
+ * ctx->out.len holds the expected response length (Le) on input, 0 meaning
+ * the maximum one. Extended length format is used when command data or
+ * expected response do not fit in a short APDU.
+ */
+static apdu_status_t APDU_setHeader(const uint8_t *header, uint8_t *buff,
+		apdu_ctx_t *ctx) {
+	bool extended = (ctx->in.len > 0xFF) || (ctx->out.len > 0x100);
+	uint32_t hdrLen = (extended) ? 7 : 5;
+	uint32_t leLen = (extended) ? 2 : 1;
+	uint8_t *body = &buff[APDU_HDR_MAX_SZ];
+	uint8_t *p = body - hdrLen;
+
+	if (APDU_HDR_MAX_SZ + ctx->in.len + leLen > APDU_BUFF_SZ)
+		return APDU_ERROR;
+
+	memcpy(&p[0], &header[0], 4);
+	if (extended) {
+		p[4] = 0x00;
+		p[5] = (ctx->in.len & 0xFF00) >> 8;
+		p[6] = ctx->in.len & 0xFF;
+	} else {
+		p[4] = ctx->in.len & 0xFF;
+	}
+	if (extended)
+		body[ctx->in.len++] = (ctx->out.len & 0xFF00) >> 8;
+	body[ctx->in.len++] = ctx->out.len & 0xFF;
+
+	ctx->in.p_data = p;
+	ctx->in.len += hdrLen;
+	return APDU_OK;
+}
 
-	memmove(&ctx->in.p_data[5], &ctx->in.p_data[0], ctx->in.len);
-	memcpy(&ctx->in.p_data[0], &header[0], 4);
-	ctx->in.p_data[4] = ctx->in.len & 0xFF;
-	ctx->in.len += 5;
-	ctx->in.p_data[ctx->in.len++] = ctx->out.len & 0xFF;
-	if(ctx->out.len == 0)
-		ctx->out.len = APDU_BUFF_SZ;
+/*
+ * Send the command APDU pointed by ctx->in and receive the response in the
+ * APDU buffer.
+ */
+static apdu_status_t APDU_transceive(apdu_ctx_t *ctx) {
+	ESESTATUS status = ESESTATUS_OK;
 
+	ctx->out.len = APDU_BUFF_SZ;
+	SE050_TRACE(SE050_TRACE_APDU_START, ctx->in.len);
+	se050_powerlog_state(SE050_PWR_ACTIVE);
 	status = phNxpEse_Transceive(&ctx->in, &ctx->out);
-	if (status == ESESTATUS_OK) {
+	se050_powerlog_state(SE050_PWR_IDLE);
+	if (status == ESESTATUS_OK && ctx->out.len >= 2) {
 		ctx->sw = ctx->out.p_data[ctx->out.len - 2] << 8
 				| ctx->out.p_data[ctx->out.len - 1];
 		ctx->out.len -= 2;
+		SE050_TRACE(SE050_TRACE_APDU_END, ctx->sw);
+		/* the end of session S-frame does not touch the response */
+		if (ctx->eosPolicy == SE050_EOS_PER_APDU && ctx->transactions == 0)
+			se050_endOfSession(ctx);
 		return APDU_OK;
 	} else {
 		ctx->out.len = 0;
 		ctx->sw = 0;
+		SE050_TRACE(SE050_TRACE_APDU_END, 0);
 		return APDU_ERROR;
 	}
 }
 
+static apdu_status_t APDU_case4(const uint8_t *header, apdu_ctx_t *ctx) {
+	CHECK_IF_ERROR(APDU_setHeader(header, ctx->buff, ctx));
+	return APDU_transceive(ctx);
+}
+
+/*
+ * Start the encoding of command data. Room is kept before data for the
+ * largest APDU header and after data for Le.
+ */
+static void initCmd(se050_tlvWriter_t *w, apdu_ctx_t *ctx) {
+	se050_tlv_initWriter(w, &ctx->buff[APDU_HDR_MAX_SZ],
+			APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2);
+}
+
+/*
+ * Send the command data encoded by w. le is the expected response length,
+ * 0 meaning the maximum one. Fails unless the SE050 returns 0x9000.
+ */
+static apdu_status_t sendCmd(const uint8_t *header, const se050_tlvWriter_t *w,
+		uint32_t le, apdu_ctx_t *ctx) {
+
+	uint32_t dataLen;
+
+	if (!se050_tlv_finish(w, &dataLen))
+		return APDU_ERROR;
+	return se050_sendCommand(header, dataLen, le, ctx);
+}
+
+/*
+ * Parse the TLVs of the current response.
+ */
+static apdu_status_t getRsp(se050_tlvView_t *view, apdu_ctx_t *ctx) {
+	if (!se050_tlv_decode(view, ctx->out.p_data, ctx->out.len))
+		return APDU_ERROR;
+	return APDU_OK;
+}
+
+/*
+ * Get the 1-byte value of a response field.
+ */
+static apdu_status_t getRspU8(const se050_tlvView_t *view, SE050_TAG_t tag,
+		uint8_t *value) {
+
+	phNxpEse_data field;
+	if (!se050_tlv_get(view, tag, &field) || field.len != 1)
+		return APDU_ERROR;
+	*value = field.p_data[0];
+	return APDU_OK;
+}
+
+/*
+ * Journal the change of an object made by the last command, whose status is
+ * status. A command rejected by the SE050 changed nothing, while a command
+ * whose response was lost may have changed anything.
+ */
+static void objChanged(apdu_status_t status, uint32_t objId,
+		se050_objChangeKind_t kind, uint8_t type, apdu_ctx_t *ctx) {
+
+	se050_objChange_t *change;
+
+	if (status != APDU_OK) {
+		if (ctx->sw != 0x0000)
+			return;
+		kind = SE050_OBJ_UNKNOWN;
+	}
+	ctx->objGeneration++;
+	change = &ctx->objChanges[ctx->objGeneration
+			% MBED_CONF_SE050_OBJ_JOURNAL_SIZE];
+	change->objId = objId;
+	change->kind = kind;
+	change->type = type;
+}
+
+/*
+ * Track the transient objects created through ctx, whose values are cleared
+ * by power cycles (see se050_reconnect()).
+ */
+static void transientChanged(apdu_status_t status, uint32_t objId,
+		bool created, apdu_ctx_t *ctx) {
+
+	uint8_t k = 0;
+
+	if (status != APDU_OK) {
+		/* a lost response may have created the object */
+		if (ctx->sw == 0x0000 && created)
+			ctx->transientsUnknown = true;
+		return;
+	}
+	while (k < ctx->nTransients && ctx->transients[k] != objId)
+		k++;
+	if (created && k == ctx->nTransients) {
+		if (ctx->nTransients < MBED_CONF_SE050_TRANSIENT_OBJECTS)
+			ctx->transients[ctx->nTransients++] = objId;
+		else
+			ctx->transientsUnknown = true;
+	} else if (!created && k < ctx->nTransients) {
+		ctx->transients[k] = ctx->transients[--ctx->nTransients];
+	}
+}
+
+static se050_yieldHook_t yieldHook = NULL;
+static void *yieldArg = NULL;
+
+/*
+ * Called between two APDUs of a streaming operation. The hook may send other
+ * commands, so nothing may be kept in the APDU buffer across this call.
+ * End of sessions requested by the hook are deferred until it returns.
+ */
+static void yieldPoint(apdu_ctx_t *ctx) {
+	if (yieldHook == NULL)
+		return;
+	ctx->yieldDepth++;
+	yieldHook(ctx, yieldArg);
+	ctx->yieldDepth--;
+	if (ctx->eosDeferred && ctx->yieldDepth == 0 && ctx->transactions == 0)
+		se050_endOfSession(ctx);
+}
+
+void se050_setYieldHook(se050_yieldHook_t hook, void *arg) {
+	yieldHook = hook;
+	yieldArg = arg;
+}
+
+static se050_sessionHook_t sessionHook = NULL;
+static void *sessionArg = NULL;
+
+void se050_setSessionHook(se050_sessionHook_t hook, void *arg) {
+	sessionHook = hook;
+	sessionArg = arg;
+}
+
+void se050_getSessionHook(se050_sessionHook_t *hook, void **arg) {
+	*hook = sessionHook;
+	*arg = sessionArg;
+}
+
 void se050_initApduCtx(apdu_ctx_t *ctx) {
 	memset(ctx, 0, sizeof(apdu_ctx_t));
 	ctx->in.len = APDU_BUFF_SZ;
@@ -195,9 +332,11 @@ void se050_initApduCtx(apdu_ctx_t *ctx) {
 	ctx->sw = 0x0000;
 }
 
-apdu_status_t se050_connect(apdu_ctx_t *ctx) {
+/*
+ * Reset the SE050 and open the T=1 session.
+ */
+static apdu_status_t openSession(apdu_ctx_t *ctx) {
 	ESESTATUS ret;
-	apdu_status_t status;
 	phNxpEse_initParams initParams = {.initMode = ESE_MODE_NORMAL};
 
 	ret = phNxpEse_open(initParams);
@@ -215,6 +354,27 @@ apdu_status_t se050_connect(apdu_ctx_t *ctx) {
 	return APDU_OK;
 }
 
+apdu_status_t se050_connect(apdu_ctx_t *ctx) {
+	CHECK_IF_ERROR(openSession(ctx));
+	/* objects may have been modified while disconnected */
+	objChanged(APDU_OK, 0, SE050_OBJ_UNKNOWN, SE050_SecureObjectType_NA, ctx);
+	return APDU_OK;
+}
+
+apdu_status_t se050_reconnect(apdu_ctx_t *ctx) {
+	CHECK_IF_ERROR(openSession(ctx));
+	if (ctx->transientsUnknown) {
+		objChanged(APDU_OK, 0, SE050_OBJ_UNKNOWN, SE050_SecureObjectType_NA,
+				ctx);
+		return APDU_OK;
+	}
+	/* the power cycle cleared the values of transient objects only */
+	for (uint8_t k = 0; k < ctx->nTransients; k++)
+		objChanged(APDU_OK, ctx->transients[k], SE050_OBJ_MODIFIED,
+				SE050_SecureObjectType_NA, ctx);
+	return APDU_OK;
+}
+
 apdu_status_t se050_disconnect(apdu_ctx_t *ctx) {
 	ESESTATUS ret;
 	if(ESESTATUS_SUCCESS != phNxpEse_close())
@@ -222,6 +382,51 @@ apdu_status_t se050_disconnect(apdu_ctx_t *ctx) {
 	return APDU_OK;
 }
 
+bool se050_getObjChange(uint32_t generation, se050_objChange_t *change,
+		const apdu_ctx_t *ctx) {
+
+	if (ctx->objGeneration - generation >= MBED_CONF_SE050_OBJ_JOURNAL_SIZE)
+		return false;
+	*change = ctx->objChanges[generation % MBED_CONF_SE050_OBJ_JOURNAL_SIZE];
+	return true;
+}
+
+void se050_setEosPolicy(se050_eosPolicy_t policy, apdu_ctx_t *ctx) {
+	ctx->eosPolicy = policy;
+}
+
+void se050_beginTransaction(apdu_ctx_t *ctx) {
+	ctx->transactions++;
+}
+
+apdu_status_t se050_endTransaction(apdu_ctx_t *ctx) {
+	if (ctx->transactions == 0 || --ctx->transactions > 0)
+		return APDU_OK;
+	if (ctx->eosPolicy == SE050_EOS_NEVER)
+		return APDU_OK;
+	return se050_endOfSession(ctx);
+}
+
+apdu_status_t se050_endOfSession(apdu_ctx_t *ctx) {
+	if (ctx->yieldDepth > 0) {
+		ctx->eosDeferred = true;
+		return APDU_OK;
+	}
+	ctx->eosDeferred = false;
+	if (phNxpEse_EndOfApdu() != ESESTATUS_SUCCESS)
+		return APDU_ERROR;
+	se050_powerlog_state(SE050_PWR_LOW);
+	return APDU_OK;
+}
+
+void se050_getStats(phNxpEse_stats_t *stats) {
+	phNxpEse_getStats(stats);
+}
+
+void se050_resetStats(void) {
+	phNxpEse_resetStats();
+}
+
 apdu_status_t se050_select(apdu_ctx_t *ctx) {
 
 	apdu_status_t status;
@@ -230,7 +435,7 @@ apdu_status_t se050_select(apdu_ctx_t *ctx) {
 			0x00, 0x00, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00 };
 
 	ctx->in.len = sizeof(applet_aid);
-	memcpy(&ctx->in.p_data[0], &applet_aid[0], ctx->in.len);
+	memcpy(&ctx->buff[APDU_HDR_MAX_SZ], &applet_aid[0], ctx->in.len);
 	ctx->out.len = 0;
 
 	status = APDU_case4(&select_header[0], ctx);
@@ -241,55 +446,802 @@ apdu_status_t se050_select(apdu_ctx_t *ctx) {
 	ctx->version.patch = ctx->out.p_data[2];
 	ctx->version.appletConfig = ctx->out.p_data[3] << 8 | ctx->out.p_data[4];
 	ctx->version.secureBox = ctx->out.p_data[5] << 8 | ctx->out.p_data[6];
+	if (sessionHook != NULL)
+		sessionHook(ctx, sessionArg);
+	return APDU_OK;
+}
+
+/*
+ * A sensor read plan is encoded as a configuration command selecting the
+ * sensor followed by the commands of the plan.
+ */
+static bool getI2CMSensorSizes(const i2cm_sensor_t *sensor, uint32_t *cmdsLen,
+		uint32_t *rspsLen) {
+
+	*cmdsLen += 3 + 2;
+	*rspsLen += 2;
+	return getI2CMSizes(sensor->tlv, sensor->sz_tlv, cmdsLen, rspsLen);
+}
+
+static void setI2CMSensorCmds(const i2cm_sensor_t *sensor,
+		se050_tlvWriter_t *w) {
+
+	uint8_t config[2] = { sensor->addr, sensor->freq };
+	i2cm_tlv_t configTlv;
+	configTlv.tag = SE050_TAG_I2CM_Config;
+	configTlv.cmd.len = 2;
+	configTlv.cmd.p_data = &config[0];
+
+	setI2CMCmds(&configTlv, 1, w);
+	setI2CMCmds(sensor->tlv, sensor->sz_tlv, w);
+}
+
+static apdu_status_t getI2CMSensorRsps(i2cm_sensor_t *sensor,
+		const phNxpEse_data *payload, uint32_t *offset) {
+
+	i2cm_tlv_t configTlv;
+	configTlv.tag = SE050_TAG_I2CM_Config;
+	CHECK_IF_ERROR(se050_i2cm_getRsps(&configTlv, 1, payload, offset));
+	sensor->sw = configTlv.sw;
+	return se050_i2cm_getRsps(sensor->tlv, sensor->sz_tlv, payload, offset);
+}
+
+/*
+ * Build an attested I2CM command APDU. I2CM commands are encoded in TAG_1,
+ * their length cmdsLen being computed beforehand. rspsLen is the maximum
+ * length of the I2CM responses. The 16-byte random is the last field
+ * before Le.
+ */
+static apdu_status_t setI2CMAttestedApdu(const i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		const i2cm_sensor_t *sensors, uint8_t nSensors, uint32_t cmdsLen,
+		uint32_t rspsLen, SE050_AttestationAlgo_t algo, const uint8_t *random,
+		apdu_ctx_t *ctx) {
+
+	const uint8_t select_header[] = { 0x80, SE050_INS_CRYPTO
+			| SE050_INS_ATTEST, SE050_P1_DEFAULT, SE050_P2_I2CM };
+	se050_tlvWriter_t w;
+
+	initCmd(&w, ctx);
+	se050_tlv_putHeader(&w, SE050_TAG_1, cmdsLen, false);
+	setI2CMCmds(tlv, sz_tlv, &w);
+	for (uint8_t k = 0; k < nSensors; k++)
+		setI2CMSensorCmds(&sensors[k], &w);
+	se050_tlv_putU32(&w, SE050_TAG_2, 0xF0000012);
+	se050_tlv_putU8(&w, SE050_TAG_3, algo);
+	se050_tlv_putArray(&w, SE050_TAG_7, random, 16);
+	if (!se050_tlv_finish(&w, &ctx->in.len))
+		return APDU_ERROR;
+	ctx->out.len = rspsLen + SE050_I2CM_ATTEST_RSP_OVERHEAD;
+
+	return APDU_setHeader(&select_header[0], ctx->buff, ctx);
+}
+
+/*
+ * Parse the attestation fields of an attested I2CM response.
+ */
+static apdu_status_t getI2CMAttestation(attestation_t *attestation,
+		apdu_ctx_t *ctx) {
+
+	se050_tlvView_t view;
+	phNxpEse_data field;
+
+	if (ctx->sw != 0x9000)
+		return APDU_ERROR;
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+
+	if (!se050_tlv_get(&view, SE050_TAG_1, &attestation->data))
+		return APDU_ERROR;
+	if (!se050_tlv_get(&view, SE050_TAG_3, &field) || field.len != 12)
+		return APDU_ERROR;
+	attestation->timeStamp = field.p_data;
+	if (!se050_tlv_get(&view, SE050_TAG_4, &field) || field.len != 16)
+		return APDU_ERROR;
+	attestation->outrandom = field.p_data;
+	if (!se050_tlv_get(&view, SE050_TAG_5, &field) || field.len != 18)
+		return APDU_ERROR;
+	attestation->chipId = field.p_data;
+	if (!se050_tlv_get(&view, SE050_TAG_6, &attestation->signature))
+		return APDU_ERROR;
+	/* signed message is made of all TLVs preceding the signature */
+	attestation->message.p_data = &ctx->out.p_data[0];
+	attestation->message.len = view.offset[SE050_TAG_6 - SE050_TAG_1];
+
 	return APDU_OK;
 }
 
+static apdu_status_t i2cmAttestedApdu(const i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		const i2cm_sensor_t *sensors, uint8_t nSensors, uint32_t cmdsLen,
+		uint32_t rspsLen, SE050_AttestationAlgo_t algo, const uint8_t *random,
+		attestation_t *attestation, apdu_ctx_t *ctx) {
+
+	CHECK_IF_ERROR(setI2CMAttestedApdu(tlv, sz_tlv, sensors, nSensors, cmdsLen,
+			rspsLen, algo, random, ctx));
+	CHECK_IF_ERROR(APDU_transceive(ctx));
+	return getI2CMAttestation(attestation, ctx);
+}
+
 apdu_status_t se050_i2cm_attestedCmds(uint8_t addr, uint8_t freq,
 		i2cm_tlv_t *tlv, uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
 		uint8_t *random, attestation_t *attestation, apdu_ctx_t *ctx) {
 
+	uint32_t cmdsLen = 0;
+	uint32_t rspsLen = 0;
+	uint32_t offset = 0;
+
+	if (!getI2CMSizes(tlv, sz_tlv, &cmdsLen, &rspsLen)
+			|| cmdsLen > SE050_I2CM_MAX_CMDS_LEN
+			|| rspsLen > SE050_I2CM_MAX_RSPS_LEN)
+		return APDU_ERROR;
+
+	CHECK_IF_ERROR(i2cmAttestedApdu(tlv, sz_tlv, NULL, 0, cmdsLen, rspsLen,
+			algo, random, attestation, ctx));
+	CHECK_IF_ERROR(se050_i2cm_getRsps(tlv, sz_tlv, &attestation->data,
+			&offset));
+
+	return APDU_OK;
+}
+
+apdu_status_t se050_i2cm_prepare(se050_i2cmPrepared_t *prepared,
+		i2cm_tlv_t *tlv, uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
+		apdu_ctx_t *ctx) {
+
+	const uint8_t random[16] = { 0 };
+	uint32_t cmdsLen = 0;
+	uint32_t rspsLen = 0;
+
+	if (!getI2CMSizes(tlv, sz_tlv, &cmdsLen, &rspsLen)
+			|| cmdsLen > SE050_I2CM_MAX_CMDS_LEN
+			|| rspsLen > SE050_I2CM_MAX_RSPS_LEN)
+		return APDU_ERROR;
+
+	CHECK_IF_ERROR(setI2CMAttestedApdu(tlv, sz_tlv, NULL, 0, cmdsLen, rspsLen,
+			algo, &random[0], ctx));
+	if (ctx->in.len > sizeof(prepared->apdu))
+		return APDU_ERROR;
+
+	memcpy(&prepared->apdu[0], &ctx->in.p_data[0], ctx->in.len);
+	prepared->len = ctx->in.len;
+	/* random is followed by a 1 or 2-byte Le */
+	prepared->randomOffset = ctx->in.len - 16
+			- ((ctx->in.p_data[4] == 0x00) ? 2 : 1);
+	prepared->tlv = tlv;
+	prepared->sz_tlv = sz_tlv;
+	return APDU_OK;
+}
+
+apdu_status_t se050_i2cm_issue(se050_i2cmPrepared_t *prepared,
+		const uint8_t *random, attestation_t *attestation, apdu_ctx_t *ctx) {
+
+	uint32_t offset = 0;
+
+	memcpy(&prepared->apdu[prepared->randomOffset], random, 16);
+	ctx->in.p_data = &prepared->apdu[0];
+	ctx->in.len = prepared->len;
+	CHECK_IF_ERROR(APDU_transceive(ctx));
+
+	CHECK_IF_ERROR(getI2CMAttestation(attestation, ctx));
+	return se050_i2cm_getRsps(prepared->tlv, prepared->sz_tlv,
+			&attestation->data, &offset);
+}
+
+apdu_status_t se050_i2cm_cmds(i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		phNxpEse_data *data, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_CRYPTO, SE050_P1_DEFAULT,
+			SE050_P2_I2CM };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+	uint32_t cmdsLen = 0;
+	uint32_t rspsLen = 0;
+	uint32_t offset = 0;
+	phNxpEse_data rsps;
+
+	if (!getI2CMSizes(tlv, sz_tlv, &cmdsLen, &rspsLen)
+			|| rspsLen + 4 + 2 > APDU_BUFF_SZ)
+		return APDU_ERROR;
+
+	initCmd(&w, ctx);
+	se050_tlv_putHeader(&w, SE050_TAG_1, cmdsLen, false);
+	setI2CMCmds(tlv, sz_tlv, &w);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, rspsLen + 4, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	if (!se050_tlv_get(&view, SE050_TAG_1, &rsps))
+		return APDU_ERROR;
+	CHECK_IF_ERROR(se050_i2cm_getRsps(tlv, sz_tlv, &rsps, &offset));
+	if (data != NULL)
+		*data = rsps;
+
+	return APDU_OK;
+}
+
+apdu_status_t se050_i2cm_plan(const i2cm_sensor_t *sensors, uint8_t nSensors,
+		uint8_t *batches, uint8_t *nBatches) {
+
+	uint8_t maxBatches = *nBatches;
+	uint32_t cmdsLen = 0;
+	uint32_t rspsLen = 0;
+	uint8_t count = 0;
+
+	*nBatches = 0;
+	for (uint8_t k = 0; k < nSensors; k++) {
+		uint32_t sensorCmdsLen = 0;
+		uint32_t sensorRspsLen = 0;
+		if (!getI2CMSensorSizes(&sensors[k], &sensorCmdsLen, &sensorRspsLen))
+			return APDU_ERROR;
+		if (sensorCmdsLen > SE050_I2CM_MAX_CMDS_LEN
+				|| sensorRspsLen > SE050_I2CM_MAX_RSPS_LEN)
+			return APDU_ERROR;
+
+		if (count > 0
+				&& (cmdsLen + sensorCmdsLen > SE050_I2CM_MAX_CMDS_LEN
+						|| rspsLen + sensorRspsLen > SE050_I2CM_MAX_RSPS_LEN)) {
+			if (*nBatches >= maxBatches)
+				return APDU_ERROR;
+			batches[(*nBatches)++] = count;
+			count = 0;
+			cmdsLen = 0;
+			rspsLen = 0;
+		}
+		cmdsLen += sensorCmdsLen;
+		rspsLen += sensorRspsLen;
+		count++;
+	}
+	if (count > 0) {
+		if (*nBatches >= maxBatches)
+			return APDU_ERROR;
+		batches[(*nBatches)++] = count;
+	}
+	return APDU_OK;
+}
+
+void se050_i2cm_batchRandom(const uint8_t *random, uint8_t index,
+		uint8_t *batchRandom) {
+
+	memcpy(batchRandom, random, 16);
+	batchRandom[15] ^= index;
+}
+
+apdu_status_t se050_i2cm_attestedBatch(i2cm_sensor_t *sensors,
+		uint8_t nSensors, SE050_AttestationAlgo_t algo, uint8_t *random,
+		se050_i2cmBatchSink_t sink, void *arg, apdu_ctx_t *ctx) {
+
+	uint8_t batches[SE050_I2CM_MAX_BATCHES];
+	uint8_t nBatches = SE050_I2CM_MAX_BATCHES;
+	uint8_t batchRandom[16];
+	attestation_t attestation;
+
+	CHECK_IF_ERROR(se050_i2cm_plan(sensors, nSensors, &batches[0], &nBatches));
+
+	i2cm_sensor_t *first = &sensors[0];
+	for (uint8_t b = 0; b < nBatches; b++) {
+		uint32_t cmdsLen = 0;
+		uint32_t rspsLen = 0;
+		uint32_t offset = 0;
+
+		for (uint8_t k = 0; k < batches[b]; k++)
+			getI2CMSensorSizes(&first[k], &cmdsLen, &rspsLen);
+
+		se050_i2cm_batchRandom(random, b, &batchRandom[0]);
+		CHECK_IF_ERROR(i2cmAttestedApdu(NULL, 0, first, batches[b], cmdsLen,
+				rspsLen, algo, &batchRandom[0], &attestation, ctx));
+		for (uint8_t k = 0; k < batches[b]; k++)
+			CHECK_IF_ERROR(getI2CMSensorRsps(&first[k], &attestation.data,
+					&offset));
+		CHECK_IF_ERROR(sink(first, batches[b], &attestation, arg));
+		first += batches[b];
+		if (b + 1 < nBatches)
+			yieldPoint(ctx);
+	}
+	return APDU_OK;
+}
+
+apdu_status_t se050_createCryptoObject(uint16_t cryptoObjId,
+		SE050_CryptoContext_t context, uint8_t subtype, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_WRITE, SE050_P1_CRYPTO_OBJ,
+			SE050_P2_DEFAULT };
+	se050_tlvWriter_t w;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU16(&w, SE050_TAG_1, cryptoObjId);
+	se050_tlv_putU8(&w, SE050_TAG_2, context);
+	se050_tlv_putU8(&w, SE050_TAG_3, subtype);
+	return sendCmd(&header[0], &w, 0, ctx);
+}
+
+apdu_status_t se050_deleteCryptoObject(uint16_t cryptoObjId, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_MGMT, SE050_P1_CRYPTO_OBJ,
+			SE050_P2_DELETE_OBJECT };
+	se050_tlvWriter_t w;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU16(&w, SE050_TAG_1, cryptoObjId);
+	return sendCmd(&header[0], &w, 0, ctx);
+}
+
+/*
+ * Copy the MAC value returned in TAG_1 of the current response to
+ * the caller buffer.
+ */
+static apdu_status_t getMACValue(uint8_t *mac, uint32_t *macLen,
+		apdu_ctx_t *ctx) {
+
+	se050_tlvView_t view;
+	phNxpEse_data value;
+
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	if (!se050_tlv_get(&view, SE050_TAG_1, &value) || value.len > *macLen)
+		return APDU_ERROR;
+	memcpy(mac, value.p_data, value.len);
+	*macLen = value.len;
+	return APDU_OK;
+}
+
+apdu_status_t se050_mac_init(uint32_t keyId, uint16_t cryptoObjId,
+		apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_CRYPTO, SE050_P1_MAC,
+			SE050_P2_GENERATE };
+	se050_tlvWriter_t w;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, keyId);
+	se050_tlv_putU16(&w, SE050_TAG_2, cryptoObjId);
+	return sendCmd(&header[0], &w, 0, ctx);
+}
+
+apdu_status_t se050_mac_update(uint16_t cryptoObjId, const uint8_t *data,
+		uint32_t dataLen, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_CRYPTO, SE050_P1_MAC,
+			SE050_P2_UPDATE };
+	se050_tlvWriter_t w;
+
+	while (dataLen > 0) {
+		uint32_t chunkLen = (dataLen > SE050_MAC_UPDATE_MAX_DATA) ?
+				SE050_MAC_UPDATE_MAX_DATA : dataLen;
+
+		initCmd(&w, ctx);
+		se050_tlv_putArray(&w, SE050_TAG_1, data, chunkLen);
+		se050_tlv_putU16(&w, SE050_TAG_2, cryptoObjId);
+		CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+		data += chunkLen;
+		dataLen -= chunkLen;
+		if (dataLen > 0)
+			yieldPoint(ctx);
+	}
+	return APDU_OK;
+}
+
+apdu_status_t se050_mac_final(uint16_t cryptoObjId, const uint8_t *data,
+		uint32_t dataLen, uint8_t *mac, uint32_t *macLen, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_CRYPTO, SE050_P1_MAC,
+			SE050_P2_FINAL };
+	se050_tlvWriter_t w;
+
+	if (dataLen > SE050_MAC_UPDATE_MAX_DATA) {
+		uint32_t updateLen = dataLen - SE050_MAC_UPDATE_MAX_DATA;
+		CHECK_IF_ERROR(se050_mac_update(cryptoObjId, data, updateLen, ctx));
+		data += updateLen;
+		dataLen -= updateLen;
+	}
+
+	initCmd(&w, ctx);
+	se050_tlv_putArray(&w, SE050_TAG_1, data, dataLen);
+	se050_tlv_putU16(&w, SE050_TAG_2, cryptoObjId);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	return getMACValue(mac, macLen, ctx);
+}
+
+apdu_status_t se050_mac_oneShot(uint32_t keyId, SE050_MACAlgo_t algo,
+		const uint8_t *data, uint32_t dataLen, uint8_t *mac, uint32_t *macLen,
+		apdu_ctx_t *ctx) {
+
 	apdu_status_t status;
+	const uint8_t header[] = { 0x80, SE050_INS_CRYPTO, SE050_P1_MAC,
+			SE050_P2_GENERATE_ONESHOT };
+	se050_tlvWriter_t w;
 
-	const uint8_t select_header[] = { 0x80, SE050_INS_CRYPTO
-			| SE050_INS_ATTEST, SE050_P1_DEFAULT, SE050_P2_I2CM };
+	if (dataLen > SE050_MAC_ONESHOT_MAX_DATA) {
+		/* a MAC suspended at a yield point keeps its crypto object */
+		const uint16_t cryptoObjId = MBED_CONF_SE050_MAC_CRYPTO_OBJ_ID
+				+ ctx->yieldDepth;
+
+		CHECK_IF_ERROR(se050_createCryptoObject(cryptoObjId,
+				SE050_CryptoContext_SIGNATURE, algo, ctx));
+		status = se050_mac_init(keyId, cryptoObjId, ctx);
+		if (status == APDU_OK)
+			status = se050_mac_final(cryptoObjId, data, dataLen, mac, macLen,
+					ctx);
+		if (se050_deleteCryptoObject(cryptoObjId, ctx) != APDU_OK)
+			return APDU_ERROR;
+		return status;
+	}
 
-	uint16_t cmdsLen;
-	cmdsLen = setI2CMCmds(tlv, sz_tlv, &ctx->in);
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, keyId);
+	se050_tlv_putU8(&w, SE050_TAG_2, algo);
+	se050_tlv_putArray(&w, SE050_TAG_3, data, dataLen);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	return getMACValue(mac, macLen, ctx);
+}
 
-	uint32_t lc = 0;
-	lc += setTLVarray(SE050_TAG_1, &ctx->in.p_data[lc], &ctx->in.p_data[0],
-			cmdsLen, false);
-	lc += setTLVU32(SE050_TAG_2, &ctx->in.p_data[lc], 0xF0000012, false);
-	lc += setTLVU8(SE050_TAG_3, &ctx->in.p_data[lc], algo, false);
-	lc += setTLVarray(SE050_TAG_7, &ctx->in.p_data[lc], random, 16, false);
-	ctx->in.len = lc; //TODO add check on data length
-	ctx->out.len = 0;
+apdu_status_t se050_writeBinary(uint32_t objId, uint16_t offset,
+		uint16_t fileLen, const uint8_t *data, uint32_t dataLen,
+		apdu_ctx_t *ctx) {
 
-	status = APDU_case4(&select_header[0], ctx);
-	if (ctx->sw != 0x9000 | ctx->out.len <= 0)
-		return APDU_ERROR;
-
-	uint32_t le = 0;
-	uint32_t tmp_le = 0;
-	uint32_t fieldLen = 0;
-	tmp_le = getTLVarray(SE050_TAG_1, &ctx->out.p_data[le], &attestation->data.p_data,
-			&attestation->data.len, false);
-	CHECK_IF_ERROR_AND_ACCUMULATE(tmp_le, le);
-	tmp_le = getTLVarray(SE050_TAG_3, &ctx->out.p_data[le],
-			&attestation->timeStamp, &fieldLen, false);
-	CHECK_IF_ERROR_AND_ACCUMULATE(tmp_le, le);
-	tmp_le = getTLVarray(SE050_TAG_4, &ctx->out.p_data[le],
-			&attestation->outrandom, &fieldLen, false);
-	CHECK_IF_ERROR_AND_ACCUMULATE(tmp_le, le);
-	tmp_le = getTLVarray(SE050_TAG_5, &ctx->out.p_data[le], &attestation->chipId,
-			&fieldLen, false);
-	CHECK_IF_ERROR_AND_ACCUMULATE(tmp_le, le);
-	tmp_le = getTLVarray(SE050_TAG_6, &ctx->out.p_data[le],
-			&attestation->signature.p_data, &fieldLen, false);
-	CHECK_IF_ERROR_AND_ACCUMULATE(tmp_le, le);
-	attestation->signature.len = fieldLen;
-
-	CHECK_IF_ERROR(getI2CMRsps(tlv, sz_tlv, &attestation->data));
+	const uint8_t header[] = { 0x80, SE050_INS_WRITE, SE050_P1_BINARY,
+			SE050_P2_DEFAULT };
+	se050_tlvWriter_t w;
+	apdu_status_t status;
+
+	if (dataLen > SE050_OBJ_WRITE_CHUNK_SZ)
+		return APDU_ERROR;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	se050_tlv_putU16(&w, SE050_TAG_2, offset);
+	if (fileLen != 0)
+		se050_tlv_putU16(&w, SE050_TAG_3, fileLen);
+	se050_tlv_putArray(&w, SE050_TAG_4, data, dataLen);
+	status = sendCmd(&header[0], &w, 0, ctx);
+	objChanged(status, objId,
+			(fileLen != 0) ? SE050_OBJ_CREATED : SE050_OBJ_MODIFIED,
+			SE050_SecureObjectType_BINARY_FILE, ctx);
+	return status;
+}
+
+apdu_status_t se050_writeBinaryStream(uint32_t objId, uint16_t fileLen,
+		se050_objSource_t source, void *arg, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_WRITE, SE050_P1_BINARY,
+			SE050_P2_DEFAULT };
+	se050_tlvWriter_t w;
+	apdu_status_t status = APDU_OK;
+	uint32_t offset = 0;
+	uint8_t *chunk;
+
+	while (offset < fileLen) {
+		uint32_t chunkLen = fileLen - offset;
+		if (chunkLen > SE050_OBJ_WRITE_CHUNK_SZ)
+			chunkLen = SE050_OBJ_WRITE_CHUNK_SZ;
+
+		initCmd(&w, ctx);
+		se050_tlv_putU32(&w, SE050_TAG_1, objId);
+		se050_tlv_putU16(&w, SE050_TAG_2, offset);
+		if (offset == 0)
+			se050_tlv_putU16(&w, SE050_TAG_3, fileLen);
+		/* source writes the chunk directly in the command */
+		se050_tlv_putHeader(&w, SE050_TAG_4, chunkLen, false);
+		chunk = se050_tlv_reserve(&w, chunkLen);
+		if (chunk == NULL || source(chunk, chunkLen, offset, arg) != chunkLen) {
+			status = APDU_ERROR;
+			break;
+		}
+		status = sendCmd(&header[0], &w, 0, ctx);
+		if (status != APDU_OK)
+			break;
+		offset += chunkLen;
+		if (offset < fileLen)
+			yieldPoint(ctx);
+	}
+	/* the object exists once its first chunk is written */
+	if (offset > 0)
+		objChanged(APDU_OK, objId, SE050_OBJ_CREATED,
+				SE050_SecureObjectType_BINARY_FILE, ctx);
+	else if (fileLen > 0)
+		objChanged(status, objId, SE050_OBJ_CREATED,
+				SE050_SecureObjectType_BINARY_FILE, ctx);
+	return status;
+}
+
+apdu_status_t se050_readObject(uint32_t objId, uint16_t offset,
+		uint16_t length, phNxpEse_data *data, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_READ, SE050_P1_DEFAULT,
+			SE050_P2_DEFAULT };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+
+	if (length > SE050_OBJ_READ_CHUNK_SZ)
+		return APDU_ERROR;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	if (length != 0) {
+		se050_tlv_putU16(&w, SE050_TAG_2, offset);
+		se050_tlv_putU16(&w, SE050_TAG_3, length);
+	}
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, (length != 0) ? length + 4 : 0, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	if (!se050_tlv_get(&view, SE050_TAG_1, data))
+		return APDU_ERROR;
+	return APDU_OK;
+}
+
+apdu_status_t se050_readObjectStream(uint32_t objId, uint16_t fileLen,
+		se050_objSink_t sink, void *arg, apdu_ctx_t *ctx) {
+
+	phNxpEse_data chunk;
+	uint32_t offset = 0;
+
+	if (fileLen == 0)
+		CHECK_IF_ERROR(se050_readSize(objId, &fileLen, ctx));
+
+	while (offset < fileLen) {
+		uint32_t chunkLen = fileLen - offset;
+		if (chunkLen > SE050_OBJ_READ_CHUNK_SZ)
+			chunkLen = SE050_OBJ_READ_CHUNK_SZ;
+
+		CHECK_IF_ERROR(se050_readObject(objId, offset, chunkLen, &chunk, ctx));
+		if (chunk.len != chunkLen)
+			return APDU_ERROR;
+		CHECK_IF_ERROR(sink(chunk.p_data, chunk.len, offset, arg));
+		offset += chunkLen;
+		if (offset < fileLen)
+			yieldPoint(ctx);
+	}
+	return APDU_OK;
+}
+
+apdu_status_t se050_readSize(uint32_t objId, uint16_t *size, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_READ, SE050_P1_DEFAULT,
+			SE050_P2_SIZE };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+	phNxpEse_data value;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	if (!se050_tlv_get(&view, SE050_TAG_1, &value) || value.len == 0
+			|| value.len > 2)
+		return APDU_ERROR;
+	*size = (value.len == 2) ?
+			(value.p_data[0] << 8 | value.p_data[1]) : value.p_data[0];
+	return APDU_OK;
+}
+
+apdu_status_t se050_deleteSecureObject(uint32_t objId, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_MGMT, SE050_P1_DEFAULT,
+			SE050_P2_DELETE_OBJECT };
+	se050_tlvWriter_t w;
+	apdu_status_t status;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	status = sendCmd(&header[0], &w, 0, ctx);
+	objChanged(status, objId, SE050_OBJ_DELETED, SE050_SecureObjectType_NA,
+			ctx);
+	transientChanged(status, objId, false, ctx);
+	return status;
+}
+
+apdu_status_t se050_checkObjectExists(uint32_t objId, bool *exists,
+		apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_MGMT, SE050_P1_DEFAULT,
+			SE050_P2_EXIST };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+	uint8_t result;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	CHECK_IF_ERROR(getRspU8(&view, SE050_TAG_1, &result));
+	*exists = (result == SE050_Result_SUCCESS);
+	return APDU_OK;
+}
+
+apdu_status_t se050_readIDList(uint16_t offset, uint8_t filter, bool *more,
+		phNxpEse_data *ids, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_READ, SE050_P1_DEFAULT,
+			SE050_P2_LIST };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+	uint8_t moreIndicator;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU16(&w, SE050_TAG_1, offset);
+	se050_tlv_putU8(&w, SE050_TAG_2, filter);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	CHECK_IF_ERROR(getRspU8(&view, SE050_TAG_1, &moreIndicator));
+	*more = (moreIndicator == SE050_MoreIndicator_MORE);
+	if (!se050_tlv_get(&view, SE050_TAG_2, ids))
+		return APDU_ERROR;
+	return APDU_OK;
+}
+
+apdu_status_t se050_readType(uint32_t objId, uint8_t *type, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_READ, SE050_P1_DEFAULT,
+			SE050_P2_TYPE };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, 0, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	return getRspU8(&view, SE050_TAG_1, type);
+}
+
+apdu_status_t se050_generateECKey(uint32_t objId, SE050_ECCurve_t curve,
+		bool transient, apdu_ctx_t *ctx) {
+
+	uint8_t header[] = { 0x80, SE050_INS_WRITE, SE050_P1_EC
+			| SE050_P1_KEY_PAIR, SE050_P2_DEFAULT };
+	se050_tlvWriter_t w;
+	apdu_status_t status;
+
+	if (transient)
+		header[1] |= SE050_INS_TRANSIENT;
 
+	initCmd(&w, ctx);
+	se050_tlv_putU32(&w, SE050_TAG_1, objId);
+	if (curve != SE050_ECCurve_NA)
+		se050_tlv_putU8(&w, SE050_TAG_2, curve);
+	status = sendCmd(&header[0], &w, 0, ctx);
+	/* without curve, the key pair of an existing object is regenerated */
+	objChanged(status, objId,
+			(curve != SE050_ECCurve_NA) ? SE050_OBJ_CREATED : SE050_OBJ_MODIFIED,
+			SE050_SecureObjectType_EC_KEY_PAIR, ctx);
+	if (transient)
+		transientChanged(status, objId, true, ctx);
+	return status;
+}
+
+apdu_status_t se050_getRandom(uint8_t *random, uint16_t len, apdu_ctx_t *ctx) {
+
+	const uint8_t header[] = { 0x80, SE050_INS_MGMT, SE050_P1_DEFAULT,
+			SE050_P2_RANDOM };
+	se050_tlvWriter_t w;
+	se050_tlvView_t view;
+	phNxpEse_data value;
+
+	if (len > SE050_RANDOM_MAX_LEN)
+		return APDU_ERROR;
+
+	initCmd(&w, ctx);
+	se050_tlv_putU16(&w, SE050_TAG_1, len);
+	CHECK_IF_ERROR(sendCmd(&header[0], &w, len + 4, ctx));
+	CHECK_IF_ERROR(getRsp(&view, ctx));
+	if (!se050_tlv_get(&view, SE050_TAG_1, &value) || value.len != len)
+		return APDU_ERROR;
+	memcpy(random, value.p_data, len);
+	return APDU_OK;
+}
+
+#define PIPE_FREE 0
+#define PIPE_ENCODED 1
+#define PIPE_RESPONDED 2
+
+static uint8_t *pipeBuff(se050_pipeline_t *pipe, uint8_t slot) {
+	return (slot == 0) ? &pipe->ctx->buff[0] : &pipe->buff[0];
+}
+
+/*
+ * Do one pending step on the spare slot: parse its response, or encode the
+ * next command in it. Returns false if there is nothing to do.
+ */
+static bool pipeStep(se050_pipeline_t *pipe) {
+	se050_pipeSlot_t *slot = &pipe->slot[pipe->spare];
+	uint32_t maxLen = APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2;
+
+	if (pipe->failed)
+		return false;
+
+	if (slot->state == PIPE_RESPONDED) {
+		if (pipe->parse(slot->index, &slot->rsp, slot->sw, pipe->arg) != APDU_OK)
+			pipe->failed = true;
+		slot->state = PIPE_FREE;
+		return true;
+	}
+
+	if (slot->state == PIPE_FREE && pipe->next < pipe->count) {
+		slot->len = maxLen;
+		slot->le = 0;
+		if (pipe->encode(pipe->next, &slot->header[0],
+				&pipeBuff(pipe, pipe->spare)[APDU_HDR_MAX_SZ], &slot->len,
+				&slot->le, pipe->arg) != APDU_OK || slot->len > maxLen)
+			pipe->failed = true;
+		slot->index = pipe->next++;
+		slot->state = PIPE_ENCODED;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * T=1 polling hook: the SE050 is busy with the command of the other slot.
+ */
+static int pipePoll(void *arg) {
+	se050_pipeline_t *pipe = (se050_pipeline_t*) arg;
+
+	if (!pipeStep(pipe))
+		return 0;
+	pipe->overlapped++;
+	return 1;
+}
+
+static void pipeDrain(se050_pipeline_t *pipe) {
+	while (pipeStep(pipe))
+		pipe->serial++;
+}
+
+apdu_status_t se050_pipeline_run(se050_pipeline_t *pipe, uint32_t count,
+		se050_pipeEncode_t encode, se050_pipeParse_t parse, void *arg,
+		apdu_ctx_t *ctx) {
+
+	apdu_status_t status = APDU_OK;
+	uint8_t cur = 0;
+
+	memset(&pipe->slot[0], 0, sizeof(pipe->slot));
+	pipe->encode = encode;
+	pipe->parse = parse;
+	pipe->arg = arg;
+	pipe->ctx = ctx;
+	pipe->count = count;
+	pipe->next = 0;
+	pipe->failed = false;
+	pipe->overlapped = 0;
+	pipe->serial = 0;
+
+	pipe->spare = cur;
+	pipeDrain(pipe);
+	while (!pipe->failed && pipe->slot[cur].state == PIPE_ENCODED) {
+		se050_pipeSlot_t *slot = &pipe->slot[cur];
+		uint8_t *buff = pipeBuff(pipe, cur);
+
+		pipe->spare = 1 - cur;
+		ctx->in.len = slot->len;
+		ctx->out.len = slot->le;
+		status = APDU_setHeader(&slot->header[0], buff, ctx);
+		if (status != APDU_OK)
+			break;
+		ctx->out.p_data = buff;
+		phNxpEse_setPollHook(pipePoll, pipe);
+		status = APDU_transceive(ctx);
+		phNxpEse_setPollHook(NULL, NULL);
+		if (status != APDU_OK)
+			break;
+
+		slot->rsp = ctx->out;
+		slot->sw = ctx->sw;
+		slot->state = PIPE_RESPONDED;
+		pipeDrain(pipe);
+		cur = 1 - cur;
+	}
+	ctx->out.p_data = &ctx->buff[0];
+
+	if (status == APDU_OK) {
+		pipe->spare = 1 - cur;
+		pipeDrain(pipe);
+	}
+	return (pipe->failed) ? APDU_ERROR : status;
+}
+
+apdu_status_t se050_sendCommand(const uint8_t *header, uint32_t dataLen,
+		uint32_t le, apdu_ctx_t *ctx) {
+
+	apdu_status_t status;
+
+	if (dataLen > APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2)
+		return APDU_ERROR;
+	ctx->in.len = dataLen;
+	ctx->out.len = le;
+
+	status = APDU_case4(header, ctx);
+	if (status != APDU_OK || ctx->sw != 0x9000)
+		return APDU_ERROR;
 	return APDU_OK;
 }
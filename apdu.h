@@ -71,6 +71,8 @@ typedef struct {
 	phNxpEse_data signature;
 	/// 12-byte time stamp returned by the SE050
 	uint8_t *timeStamp;
+	/// Structure containing a pointer to the signed part of the response (all TLVs before the signature) and its length
+	phNxpEse_data message;
 } attestation_t;
 
 /**
@@ -93,6 +95,52 @@ typedef struct {
  * @biref Size of the APDU buffer
  */
 #define APDU_BUFF_SZ 900
+/**
+ * @brief Room kept at the beginning of the APDU buffer for the largest APDU
+ * header (CLA, INS, P1, P2 and 3-byte extended Lc). Command data are written
+ * after it and the header is added in place.
+ */
+#define APDU_HDR_MAX_SZ 7
+/**
+ * @brief End of session policy. An end of session S-frame lets the SE050
+ * enter its low power mode until the next APDU wakes it up.
+ */
+typedef enum {
+	SE050_EOS_NEVER = 0,		///< Never send end of session
+	SE050_EOS_PER_APDU,			///< Send end of session after each APDU
+	SE050_EOS_PER_TRANSACTION	///< Send end of session at se050_endTransaction()
+} se050_eosPolicy_t;
+
+#ifndef MBED_CONF_SE050_OBJ_JOURNAL_SIZE
+#define MBED_CONF_SE050_OBJ_JOURNAL_SIZE 8
+#endif
+
+#ifndef MBED_CONF_SE050_TRANSIENT_OBJECTS
+#define MBED_CONF_SE050_TRANSIENT_OBJECTS 4
+#endif
+
+/**
+ * @brief Kind of change made to a secure object by this driver.
+ */
+typedef enum {
+	SE050_OBJ_UNKNOWN = 0,	///< Any object may have changed (connection, lost response)
+	SE050_OBJ_CREATED,		///< Object created
+	SE050_OBJ_MODIFIED,		///< Object content changed
+	SE050_OBJ_DELETED		///< Object deleted
+} se050_objChangeKind_t;
+
+/**
+ * @brief Change made to a secure object, see se050_getObjChange().
+ */
+typedef struct {
+	/// Object identifier (unused for SE050_OBJ_UNKNOWN)
+	uint32_t objId;
+	/// Kind of change
+	se050_objChangeKind_t kind;
+	/// Type of a created object (SE050_SecureObjectType_t)
+	uint8_t type;
+} se050_objChange_t;
+
 /**
  * @brief Structure storing the context of the connection.
  */
@@ -113,6 +161,24 @@ typedef struct {
 	phNxpEse_data out;
 	/// Status word related to the current command response.
 	uint16_t sw;
+	/// Incremented each time this driver may have changed an object
+	uint32_t objGeneration;
+	/// Last object changes, the one which set objGeneration to g is at index g % MBED_CONF_SE050_OBJ_JOURNAL_SIZE
+	se050_objChange_t objChanges[MBED_CONF_SE050_OBJ_JOURNAL_SIZE];
+	/// End of session policy
+	se050_eosPolicy_t eosPolicy;
+	/// Number of pending se050_beginTransaction() calls
+	uint32_t transactions;
+	/// Transient objects created through this context, see se050_reconnect()
+	uint32_t transients[MBED_CONF_SE050_TRANSIENT_OBJECTS];
+	/// Number of entries of transients
+	uint8_t nTransients;
+	/// Set if transient objects may exist which are not listed in transients
+	bool transientsUnknown;
+	/// Number of streaming operations suspended at a yield point (see se050_setYieldHook())
+	uint8_t yieldDepth;
+	/// Set when an end of session has been deferred by a suspended operation
+	bool eosDeferred;
 } apdu_ctx_t;
 
 /**
@@ -130,6 +196,21 @@ void se050_initApduCtx(apdu_ctx_t *ctx);
  */
 apdu_status_t se050_connect(apdu_ctx_t *apdu_ctx);
 
+/**
+ * Connect again to a SE050 which has been switched off by this host, e.g. by
+ * the idle power manager (see se050_power.h). Unlike se050_connect(), which
+ * journals that any object may have changed, only the transient objects
+ * created through ctx are journaled as modified, since the power cycle
+ * cleared their values: se050_dir and se050_pkcache keep their other entries.
+ * If more than MBED_CONF_SE050_TRANSIENT_OBJECTS transient objects have been
+ * created, or if the creation of one of them was not acknowledged, any object
+ * is journaled as changed. Objects must not have been changed by another host
+ * while the SE050 was off.
+ * @param ctx Pointer to a context previously connected with se050_connect()
+ * @returns status indicating if connect is successful
+ */
+apdu_status_t se050_reconnect(apdu_ctx_t *ctx);
+
 /**
  * Disconnect from SE050 chip.
  * @param ctx Pointer to an initialized APDU context structure
@@ -137,6 +218,64 @@ apdu_status_t se050_connect(apdu_ctx_t *apdu_ctx);
  */
 apdu_status_t se050_disconnect(apdu_ctx_t *ctx);
 
+/**
+ * Get the object change which set apdu_ctx_t.objGeneration to generation.
+ * Caches use it to update the entries of the changed object only.
+ * @param generation Value of objGeneration after the change
+ * @param change Pointer to the change
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns false if the change is not journaled (any more)
+ */
+bool se050_getObjChange(uint32_t generation, se050_objChange_t *change,
+		const apdu_ctx_t *ctx);
+
+/**
+ * Set the end of session policy. SE050_EOS_NEVER is the default one.
+ * @param policy End of session policy
+ * @param ctx Pointer to an initialized APDU context structure
+ */
+void se050_setEosPolicy(se050_eosPolicy_t policy, apdu_ctx_t *ctx);
+
+/**
+ * Start a logical transaction made of several APDUs. With the
+ * SE050_EOS_PER_APDU policy, no end of session is sent within a transaction.
+ * Transactions may be nested.
+ * @param ctx Pointer to an initialized APDU context structure
+ */
+void se050_beginTransaction(apdu_ctx_t *ctx);
+
+/**
+ * End a logical transaction. Once the outermost transaction ends, an end of
+ * session is sent unless the policy is SE050_EOS_NEVER.
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status of the end of session
+ */
+apdu_status_t se050_endTransaction(apdu_ctx_t *ctx);
+
+/**
+ * Send an end of session S-frame so that the SE050 enters its low power mode.
+ * The next APDU wakes it up, no reconnection or reselection is needed.
+ * While a streaming operation is suspended at a yield point, the end of
+ * session is deferred (see se050_yieldHook_t).
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the SE050 acknowledged the end of session
+ */
+apdu_status_t se050_endOfSession(apdu_ctx_t *ctx);
+
+/**
+ * Get T=1 over I2C protocol statistics: frames and bytes on the wire,
+ * retransmissions, R-NACKs, CRC errors, WTX requests, resynchronizations,
+ * interface resets and NAD polls. Counters survive reconnections, growing
+ * error counters relative to frame counters indicate a degrading bus.
+ * @param stats Receives a copy of the counters
+ */
+void se050_getStats(phNxpEse_stats_t *stats);
+
+/**
+ * Clear protocol statistics.
+ */
+void se050_resetStats(void);
+
 /**
  * Allows select the applet programmed in the SE050 chip.
  * This command fills the firmware version filed of the APDU context.
@@ -159,7 +298,8 @@ apdu_status_t se050_select(apdu_ctx_t *apdu_ctx);
  * @param random Pointer to an 16-byte buffer containing random data
  * @param attestation Pointer to an attestation structure
  * @param ctx Pointer to an initialized APDU context structure
- * @returns status indicating SE050 applet is properly selected
+ * @returns status indicating SE050 applet is properly selected, APDU_ERROR
+ * if commands and responses do not fit in a single APDU
  *
  * Example:
  * @code
@@ -206,6 +346,611 @@ apdu_status_t se050_i2cm_attestedCmds(uint8_t addr, uint8_t freq,
 		i2cm_tlv_t *tlv, uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
 		uint8_t *random, attestation_t *attestation, apdu_ctx_t *ctx);
 
+#ifndef MBED_CONF_SE050_PREPARED_APDU_SIZE
+#define MBED_CONF_SE050_PREPARED_APDU_SIZE 128
+#endif
+
+/**
+ * Attested I2CM command APDU encoded once and issued many times. Only the
+ * 16-byte random is patched before each issue.
+ */
+typedef struct {
+	/// Encoded command APDU
+	uint8_t apdu[MBED_CONF_SE050_PREPARED_APDU_SIZE];
+	/// Length of the encoded command APDU
+	uint32_t len;
+	/// Offset of the random in the encoded command APDU
+	uint32_t randomOffset;
+	/// I2C commands receiving responses
+	i2cm_tlv_t *tlv;
+	/// Size of the tlv array
+	uint8_t sz_tlv;
+} se050_i2cmPrepared_t;
+
+/**
+ * Encode an attested set of I2CM commands once. The tlv array is referenced
+ * by the prepared command and receives responses each time it is issued, its
+ * commands must not be modified afterwards.
+ * @param prepared Pointer to the prepared command structure
+ * @param tlv Pointer to an array of I2C commands (including configuration command)
+ * @param sz_tlv Size of the tlv array
+ * @param algo Algorithm which has to be used for the attestation generation
+ * @param ctx Pointer to an initialized APDU context structure (its buffer is used for encoding)
+ * @returns APDU_ERROR if the command does not fit in MBED_CONF_SE050_PREPARED_APDU_SIZE
+ */
+apdu_status_t se050_i2cm_prepare(se050_i2cmPrepared_t *prepared,
+		i2cm_tlv_t *tlv, uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
+		apdu_ctx_t *ctx);
+
+/**
+ * Issue a prepared attested I2CM command.
+ * @param prepared Pointer to a prepared command structure
+ * @param random Pointer to an 16-byte buffer containing random data
+ * @param attestation Pointer to an attestation structure
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if commands have been executed and attested
+ */
+apdu_status_t se050_i2cm_issue(se050_i2cmPrepared_t *prepared,
+		const uint8_t *random, attestation_t *attestation, apdu_ctx_t *ctx);
+
+/**
+ * Execute a set of I2CM commands without attestation. No signature is computed
+ * by the SE050, which makes this command suitable for high-rate sampling.
+ * Unlike se050_i2cm_attestedCmds(), data read from the sensor cannot be
+ * trusted if the host processor is compromised (see se050_sampler.h for
+ * a mode attesting only some of the reads).
+ * @param tlv Pointer to an array of I2C commands (including configuration command)
+ * @param sz_tlv Size of the tlv array
+ * @param data Structure receiving a pointer to the raw I2CM responses in the APDU buffer and its length, may be NULL
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if commands have been executed
+ */
+apdu_status_t se050_i2cm_cmds(i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		phNxpEse_data *data, apdu_ctx_t *ctx);
+
+#ifndef SE050_I2CM_ATTEST_SIG_MAX_LEN
+/**
+ * Maximum length of an attestation signature (DER encoded ECDSA signature
+ * on NIST P-521). Must be increased if RSA attestation keys are used.
+ */
+#define SE050_I2CM_ATTEST_SIG_MAX_LEN 141
+#endif
+
+/**
+ * Maximum length of the fields of an attested I2CM response which are not
+ * I2CM responses (time stamp, random, chip id and signature).
+ */
+#define SE050_I2CM_ATTEST_RSP_OVERHEAD (4 + 14 + 18 + 20 + 3 + SE050_I2CM_ATTEST_SIG_MAX_LEN)
+
+/**
+ * Maximum length of the encoded I2CM commands sent by a single attested APDU.
+ */
+#define SE050_I2CM_MAX_CMDS_LEN (APDU_BUFF_SZ - 7 - 2 - 4 - 6 - 3 - 18)
+
+/**
+ * Maximum length of the encoded I2CM responses returned by a single attested APDU.
+ */
+#define SE050_I2CM_MAX_RSPS_LEN (APDU_BUFF_SZ - 2 - SE050_I2CM_ATTEST_RSP_OVERHEAD)
+
+#ifndef SE050_I2CM_MAX_BATCHES
+/**
+ * Maximum number of APDUs sent by se050_i2cm_attestedBatch().
+ */
+#define SE050_I2CM_MAX_BATCHES 8
+#endif
+
+/**
+ * Read plan of a single I2C sensor.
+ */
+typedef struct {
+	/// Address of the I2C sensor
+	uint8_t addr;
+	/// Frequency of the I2C bus (I2CM_100KHz or I2CM_400KHz)
+	uint8_t freq;
+	/// Commands sent to the sensor, without configuration command
+	i2cm_tlv_t *tlv;
+	/// Size of the tlv array
+	uint8_t sz_tlv;
+	/// Status of the configuration command selecting the sensor
+	uint8_t sw;
+} i2cm_sensor_t;
+
+/**
+ * Callback receiving the responses of the sensors sent in a single attested
+ * APDU. Responses and attestation point to the APDU buffer and are only valid
+ * during the call.
+ * @param sensors Pointer to the first sensor of the APDU
+ * @param nSensors Number of sensors in the APDU
+ * @param attestation Pointer to the attestation of the APDU
+ * @param arg Argument given to se050_i2cm_attestedBatch()
+ * @returns APDU_OK to continue with next APDU
+ */
+typedef apdu_status_t (*se050_i2cmBatchSink_t)(const i2cm_sensor_t *sensors,
+		uint8_t nSensors, const attestation_t *attestation, void *arg);
+
+/**
+ * Split a list of sensor read plans into as few attested APDUs as possible.
+ * Sensors are kept in order and an APDU is closed only when the next sensor
+ * does not fit, either in the command or in the worst-case response.
+ * @param sensors Array of sensor read plans
+ * @param nSensors Size of the sensors array
+ * @param batches Array receiving the number of sensors of each APDU
+ * @param nBatches Size of the batches array on input, number of APDUs on output
+ * @returns APDU_ERROR if a sensor does not fit alone in an APDU or if batches is too small
+ */
+apdu_status_t se050_i2cm_plan(const i2cm_sensor_t *sensors, uint8_t nSensors,
+		uint8_t *batches, uint8_t *nBatches);
+
+/**
+ * Read several I2C sensors using as few attested APDUs as possible (see
+ * se050_i2cm_plan()). Each APDU is attested, its responses are given to the
+ * sink callback before the next APDU is sent. Each APDU is attested with its
+ * own random, derived from the caller random and its index in the batch (see
+ * se050_i2cm_batchRandom()), so that a response cannot be moved to another
+ * APDU of the same batch without being detected. The verifier recomputes the
+ * random of each APDU from the caller random and the position of the APDU.
+ * @param sensors Array of sensor read plans
+ * @param nSensors Size of the sensors array
+ * @param algo Algorithm which has to be used for the attestation generation
+ * @param random Pointer to an 16-byte buffer containing random data, used as is by the first APDU
+ * @param sink Callback receiving responses of each APDU
+ * @param arg Argument passed to the sink callback
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if all sensors have been read
+ *
+ * Example:
+ * @code
+ *	i2cm_tlv_t tmp3[2] = {0};
+ *	i2cm_tlv_t hum[3] = {0};
+ *	// fill commands as for se050_i2cm_attestedCmds(), without configuration
+ *	i2cm_sensor_t sensors[2] = {
+ *		{ 0x48, I2CM_400KHz, &tmp3[0], 2 },
+ *		{ 0x40, I2CM_400KHz, &hum[0], 3 },
+ *	};
+ *
+ *	status = se050_i2cm_attestedBatch(&sensors[0], 2, algo, &random[0],
+ *			store_attestation, NULL, ctx);
+ * @endcode
+ */
+apdu_status_t se050_i2cm_attestedBatch(i2cm_sensor_t *sensors,
+		uint8_t nSensors, SE050_AttestationAlgo_t algo, uint8_t *random,
+		se050_i2cmBatchSink_t sink, void *arg, apdu_ctx_t *ctx);
+
+/**
+ * Compute the random of an APDU of se050_i2cm_attestedBatch(): the caller
+ * random with the index of the APDU XORed into its last byte.
+ * @param random Pointer to the 16-byte random given to se050_i2cm_attestedBatch()
+ * @param index Index of the APDU in the batch, from 0
+ * @param batchRandom Buffer receiving the 16-byte random of the APDU
+ */
+void se050_i2cm_batchRandom(const uint8_t *random, uint8_t index,
+		uint8_t *batchRandom);
+
+/**
+ * Maximum length of data which can be authenticated by se050_mac_oneShot()
+ * in a single APDU. Key id (6 bytes), algorithm (3 bytes) and data TLVs
+ * (up to 4 header bytes) must fit in the APDU buffer with the largest header
+ * and an extended Le.
+ */
+#define SE050_MAC_ONESHOT_MAX_DATA (APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2 - 6 - 3 - 4)
+
+/**
+ * Maximum length of data sent by a single MACUpdate APDU.
+ */
+#define SE050_MAC_UPDATE_MAX_DATA (0xFF - 4 - 3)
+
+/**
+ * Create a crypto object which can be used by multi-step cryptographic operations.
+ * @param cryptoObjId 2-byte identifier of the crypto object
+ * @param context Kind of operation the crypto object is used for
+ * @param subtype Algorithm related to the context (e.g. a SE050_MACAlgo_t value)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the crypto object has been created
+ */
+apdu_status_t se050_createCryptoObject(uint16_t cryptoObjId,
+		SE050_CryptoContext_t context, uint8_t subtype, apdu_ctx_t *ctx);
+
+/**
+ * Delete a crypto object.
+ * @param cryptoObjId 2-byte identifier of the crypto object
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the crypto object has been deleted
+ */
+apdu_status_t se050_deleteCryptoObject(uint16_t cryptoObjId, apdu_ctx_t *ctx);
+
+/**
+ * Compute a MAC over data using a key stored in the SE050.
+ * If data fit in a single APDU (see SE050_MAC_ONESHOT_MAX_DATA), a single
+ * MACOneShot command is sent. Otherwise, the crypto object
+ * MBED_CONF_SE050_MAC_CRYPTO_OBJ_ID is temporarily created and the MAC
+ * is computed using MACInit/MACUpdate/MACFinal. When called from a yield
+ * hook (see se050_setYieldHook()) while n streaming operations are suspended,
+ * the crypto object MBED_CONF_SE050_MAC_CRYPTO_OBJ_ID + n is used instead, so
+ * that a suspended MAC computation keeps its own crypto object.
+ * @param keyId Identifier of the HMAC or AES key object
+ * @param algo MAC algorithm
+ * @param data Pointer to data to authenticate
+ * @param dataLen Length of data
+ * @param mac Pointer to the buffer receiving the MAC value
+ * @param macLen Size of the mac buffer as input, length of the MAC value as output
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the MAC has been computed
+ *
+ * Example:
+ * @code
+ *	uint8_t mac[32];
+ *	uint32_t macLen = sizeof(mac);
+ *
+ *	status = se050_mac_oneShot(0x00001234, SE050_MACAlgo_HMAC_SHA256,
+ *			frame, frameLen, &mac[0], &macLen, ctx);
+ * @endcode
+ */
+apdu_status_t se050_mac_oneShot(uint32_t keyId, SE050_MACAlgo_t algo,
+		const uint8_t *data, uint32_t dataLen, uint8_t *mac, uint32_t *macLen,
+		apdu_ctx_t *ctx);
+
+/**
+ * Start a multi-step MAC computation. The crypto object must have been
+ * created beforehand with se050_createCryptoObject() using the
+ * SE050_CryptoContext_SIGNATURE context and the MAC algorithm as subtype.
+ * @param keyId Identifier of the HMAC or AES key object
+ * @param cryptoObjId Identifier of the crypto object
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the MAC computation has been initialized
+ */
+apdu_status_t se050_mac_init(uint32_t keyId, uint16_t cryptoObjId,
+		apdu_ctx_t *ctx);
+
+/**
+ * Feed data to a multi-step MAC computation. Data longer than
+ * SE050_MAC_UPDATE_MAX_DATA are split over several APDUs.
+ * @param cryptoObjId Identifier of the crypto object
+ * @param data Pointer to data to authenticate
+ * @param dataLen Length of data
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if data have been processed
+ */
+apdu_status_t se050_mac_update(uint16_t cryptoObjId, const uint8_t *data,
+		uint32_t dataLen, apdu_ctx_t *ctx);
+
+/**
+ * Finish a multi-step MAC computation.
+ * @param cryptoObjId Identifier of the crypto object
+ * @param data Pointer to the last data to authenticate (may be NULL if dataLen is 0)
+ * @param dataLen Length of data
+ * @param mac Pointer to the buffer receiving the MAC value
+ * @param macLen Size of the mac buffer as input, length of the MAC value as output
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the MAC has been computed
+ */
+apdu_status_t se050_mac_final(uint16_t cryptoObjId, const uint8_t *data,
+		uint32_t dataLen, uint8_t *mac, uint32_t *macLen, apdu_ctx_t *ctx);
+
+/**
+ * Maximum length of data written by a single WriteBinary APDU. Object id,
+ * offset, file length and data TLVs must fit in an extended command APDU
+ * stored in the APDU buffer.
+ */
+#define SE050_OBJ_WRITE_CHUNK_SZ (APDU_BUFF_SZ - 7 - 2 - 6 - 4 - 4 - 4)
+
+/**
+ * Maximum length of data returned by a single ReadObject APDU. Data TLV and
+ * status word must fit in the APDU buffer.
+ */
+#define SE050_OBJ_READ_CHUNK_SZ (APDU_BUFF_SZ - 4 - 2)
+
+/**
+ * Callback providing the chunks of a binary object written by se050_writeBinaryStream().
+ * @param buff Pointer to the APDU buffer location where the chunk has to be written
+ * @param len Number of bytes to write
+ * @param offset Offset of the chunk in the object
+ * @param arg User argument
+ * @returns number of bytes written in buff (anything but len aborts the transfer)
+ */
+typedef uint32_t (*se050_objSource_t)(uint8_t *buff, uint32_t len,
+		uint32_t offset, void *arg);
+
+/**
+ * Callback consuming the chunks of an object read by se050_readObjectStream().
+ * Chunk data are only valid until the callback returns.
+ * @param buff Pointer to the chunk located in the APDU buffer
+ * @param len Length of the chunk
+ * @param offset Offset of the chunk in the object
+ * @param arg User argument
+ * @returns APDU_OK to continue the transfer, APDU_ERROR to abort it
+ */
+typedef apdu_status_t (*se050_objSink_t)(const uint8_t *buff, uint32_t len,
+		uint32_t offset, void *arg);
+
+/**
+ * Write data to a binary file object using a single APDU.
+ * @param objId Identifier of the binary object
+ * @param offset Offset in the binary object
+ * @param fileLen Length of the binary object, only used when the object is created (0 otherwise)
+ * @param data Pointer to data to write
+ * @param dataLen Length of data (at most SE050_OBJ_WRITE_CHUNK_SZ)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if data have been written
+ */
+apdu_status_t se050_writeBinary(uint32_t objId, uint16_t offset,
+		uint16_t fileLen, const uint8_t *data, uint32_t dataLen,
+		apdu_ctx_t *ctx);
+
+/**
+ * Create a binary file object and fill it chunk by chunk. Each chunk is written
+ * by the source callback directly in the APDU buffer so that the object never
+ * needs to be stored in host RAM.
+ * @param objId Identifier of the binary object
+ * @param fileLen Length of the binary object
+ * @param source Callback providing object data
+ * @param arg User argument passed to the source callback
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the object has been written
+ */
+apdu_status_t se050_writeBinaryStream(uint32_t objId, uint16_t fileLen,
+		se050_objSource_t source, void *arg, apdu_ctx_t *ctx);
+
+/**
+ * Read an object (or a part of a binary object) using a single APDU.
+ * @param objId Identifier of the object
+ * @param offset Offset in the binary object
+ * @param length Number of bytes to read (at most SE050_OBJ_READ_CHUNK_SZ), 0 to read a whole key object
+ * @param data Structure receiving a pointer to read data in the APDU buffer and its length
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the object has been read
+ */
+apdu_status_t se050_readObject(uint32_t objId, uint16_t offset,
+		uint16_t length, phNxpEse_data *data, apdu_ctx_t *ctx);
+
+/**
+ * Read a binary object chunk by chunk. Each chunk is passed to the sink
+ * callback while still located in the APDU buffer.
+ * @param objId Identifier of the binary object
+ * @param fileLen Length of the object, 0 to query it using se050_readSize()
+ * @param sink Callback consuming object data
+ * @param arg User argument passed to the sink callback
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the object has been read
+ *
+ * Example (measuring read throughput):
+ * @code
+ *	static apdu_status_t discard(const uint8_t *buff, uint32_t len,
+ *			uint32_t offset, void *arg) {
+ *		return APDU_OK;
+ *	}
+ *
+ *	Timer t;
+ *	t.start();
+ *	status = se050_readObjectStream(objId, fileLen, discard, NULL, ctx);
+ *	t.stop();
+ *	printf("%lu B/ms (kB/s)\n", fileLen / t.read_ms());
+ * @endcode
+ */
+apdu_status_t se050_readObjectStream(uint32_t objId, uint16_t fileLen,
+		se050_objSink_t sink, void *arg, apdu_ctx_t *ctx);
+
+/**
+ * Get the size of an object.
+ * @param objId Identifier of the object
+ * @param size Pointer to the size of the object
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the size has been read
+ */
+apdu_status_t se050_readSize(uint32_t objId, uint16_t *size, apdu_ctx_t *ctx);
+
+/**
+ * Delete a secure object.
+ * @param objId Identifier of the object
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the object has been deleted
+ */
+apdu_status_t se050_deleteSecureObject(uint32_t objId, apdu_ctx_t *ctx);
+
+/**
+ * Check if a secure object exists.
+ * @param objId Identifier of the object
+ * @param exists Pointer to the result
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the command has been executed
+ */
+apdu_status_t se050_checkObjectExists(uint32_t objId, bool *exists,
+		apdu_ctx_t *ctx);
+
+/**
+ * Read a page of the list of object identifiers.
+ * @param offset Index of the first identifier to return
+ * @param filter Object type filter (0xFF for all objects)
+ * @param more Set to true when more identifiers are available
+ * @param ids Structure receiving a pointer to the list of 4-byte identifiers in the APDU buffer and its length
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the list has been read
+ */
+apdu_status_t se050_readIDList(uint16_t offset, uint8_t filter, bool *more,
+		phNxpEse_data *ids, apdu_ctx_t *ctx);
+
+/**
+ * Get the type of a secure object.
+ * @param objId Identifier of the object
+ * @param type Pointer to the object type (SE050_SecureObjectType_t)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the type has been read
+ */
+apdu_status_t se050_readType(uint32_t objId, uint8_t *type, apdu_ctx_t *ctx);
+
+/**
+ * Generate an EC key pair in the SE050. The public key can then be read using
+ * se050_readObject() with a null length.
+ * @param objId Identifier of the key pair object
+ * @param curve Curve of the key pair to create, SE050_ECCurve_NA to generate
+ * a new key pair in an existing object
+ * @param transient True to create a transient object (key values are lost on deselect or reset)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the key pair has been generated
+ */
+apdu_status_t se050_generateECKey(uint32_t objId, SE050_ECCurve_t curve,
+		bool transient, apdu_ctx_t *ctx);
+
+/**
+ * Maximum number of random bytes returned by a single se050_getRandom() call.
+ */
+#define SE050_RANDOM_MAX_LEN (APDU_BUFF_SZ - 4 - 2)
+
+/**
+ * Get random bytes from the SE050 random number generator.
+ * @param random Buffer receiving random bytes
+ * @param len Number of random bytes (at most SE050_RANDOM_MAX_LEN)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if random bytes have been generated
+ */
+apdu_status_t se050_getRandom(uint8_t *random, uint16_t len, apdu_ctx_t *ctx);
+
+/**
+ * Hook called between two APDUs of streaming operations (se050_mac_update(),
+ * se050_writeBinaryStream(), se050_readObjectStream() and
+ * se050_i2cm_attestedBatch()). The hook may send other commands on ctx, e.g.
+ * to serve urgent requests before the streaming operation goes on. These
+ * commands are part of the session of the suspended operation: end of
+ * sessions they request (see se050_endOfSession()) are deferred until the
+ * hook returns, and sent then only if the suspended operation is not part of a
+ * transaction.
+ */
+typedef void (*se050_yieldHook_t)(apdu_ctx_t *ctx, void *arg);
+
+/**
+ * Set the hook called between two APDUs of streaming operations.
+ * @param hook Hook, NULL to disable yield points
+ * @param arg Argument of the hook
+ */
+void se050_setYieldHook(se050_yieldHook_t hook, void *arg);
+
+/**
+ * Hook called at the end of each successful se050_select(), once a session
+ * with the applet is established, e.g. to warm caches up. The hook may send
+ * other commands on ctx.
+ */
+typedef void (*se050_sessionHook_t)(apdu_ctx_t *ctx, void *arg);
+
+/**
+ * Set the hook called when a session with the applet is established.
+ * @param hook Hook, NULL to disable it
+ * @param arg Argument of the hook
+ */
+void se050_setSessionHook(se050_sessionHook_t hook, void *arg);
+
+/**
+ * Get the hook called when a session with the applet is established, so that
+ * a new hook can chain it.
+ * @param hook Pointer receiving the hook, NULL if none is set
+ * @param arg Pointer receiving the argument of the hook
+ */
+void se050_getSessionHook(se050_sessionHook_t *hook, void **arg);
+
+/**
+ * Callback encoding a command of a pipeline.
+ * @param index Index of the command in the pipeline
+ * @param header Receives the 4-byte command header (CLA, INS, P1, P2)
+ * @param data Buffer receiving command data
+ * @param len Size of data on input, length of command data on output
+ * @param le Receives the expected response length, 0 for the maximum one
+ * @param arg Argument given to se050_pipeline_run()
+ * @returns APDU_OK if the command has been encoded
+ */
+typedef apdu_status_t (*se050_pipeEncode_t)(uint32_t index, uint8_t *header,
+		uint8_t *data, uint32_t *len, uint32_t *le, void *arg);
+
+/**
+ * Callback parsing a response of a pipeline.
+ * @param index Index of the command in the pipeline
+ * @param rsp Response data, without status word
+ * @param sw Status word of the response
+ * @param arg Argument given to se050_pipeline_run()
+ * @returns APDU_OK to go on with the pipeline
+ */
+typedef apdu_status_t (*se050_pipeParse_t)(uint32_t index,
+		const phNxpEse_data *rsp, uint16_t sw, void *arg);
+
+/**
+ * State of a command pipeline buffer.
+ */
+typedef struct {
+	/// Header of the encoded command
+	uint8_t header[4];
+	/// Length of encoded command data
+	uint32_t len;
+	/// Expected response length
+	uint32_t le;
+	/// Response, valid once the command has been sent
+	phNxpEse_data rsp;
+	/// Status word of the response
+	uint16_t sw;
+	/// Index of the command held by the buffer
+	uint32_t index;
+	/// 0: free, 1: command encoded, 2: response received
+	uint8_t state;
+} se050_pipeSlot_t;
+
+/**
+ * Command pipeline. A pipeline sends a sequence of commands using the APDU
+ * buffer of the context and a second buffer. While the SE050 processes
+ * command N in one buffer, the response of command N-1 is parsed and command
+ * N+1 is encoded in the other one, from the T=1 polling loop.
+ */
+typedef struct {
+	/// Second APDU buffer
+	uint8_t buff[APDU_BUFF_SZ];
+	/// State of each buffer, slot 0 is the APDU buffer of the context
+	se050_pipeSlot_t slot[2];
+	/// Encoding callback
+	se050_pipeEncode_t encode;
+	/// Parsing callback
+	se050_pipeParse_t parse;
+	/// Argument of the callbacks
+	void *arg;
+	/// Context the pipeline runs on
+	apdu_ctx_t *ctx;
+	/// Number of commands of the pipeline
+	uint32_t count;
+	/// Index of the next command to encode
+	uint32_t next;
+	/// Slot which is not used by the command being processed by the SE050
+	uint8_t spare;
+	/// Set if a callback failed
+	bool failed;
+	/// Number of encodings and parsings done while the SE050 was busy
+	uint32_t overlapped;
+	/// Number of encodings and parsings done while the SE050 was idle
+	uint32_t serial;
+} se050_pipeline_t;
+
+/**
+ * Send count commands through a pipeline. Callbacks are called in order:
+ * parsing of response N always precedes encoding of command N+2. They run
+ * within the T=1 polling loop and must not send commands themselves.
+ * @param pipe Pipeline, overlapped and serial counters are reset
+ * @param count Number of commands
+ * @param encode Encoding callback
+ * @param parse Parsing callback
+ * @param arg Argument of the callbacks
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns APDU_ERROR if a command cannot be sent or a callback failed
+ */
+apdu_status_t se050_pipeline_run(se050_pipeline_t *pipe, uint32_t count,
+		se050_pipeEncode_t encode, se050_pipeParse_t parse, void *arg,
+		apdu_ctx_t *ctx);
+
+/**
+ * Send a command whose data have already been encoded in the APDU buffer,
+ * starting at offset APDU_HDR_MAX_SZ. This is the entry point of command
+ * layers built outside of this file (see se050_commands.hpp).
+ * @param header Pointer to the 4-byte command header (CLA, INS, P1, P2)
+ * @param dataLen Length of command data
+ * @param le Expected response length, 0 for the maximum one
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns APDU_ERROR if the command cannot be sent or if the status word is not 0x9000
+ */
+apdu_status_t se050_sendCommand(const uint8_t *header, uint32_t dataLen,
+		uint32_t le, apdu_ctx_t *ctx);
+
 #ifdef __cplusplus
 }
 #endif
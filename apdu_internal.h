@@ -0,0 +1,51 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_APDU_INTERNAL_H_
+#define SE050_DRV_APDU_INTERNAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file apdu_internal.h
+ * @author Michael Grand
+ *
+ * Internal functions of apdu.c, exposed to the host tools (tools/bench) only.
+ * They are not part of the driver API and applications must not include this
+ * file.
+ */
+
+/**
+ * Parse the responses of a set of I2CM commands, as done by the I2CM
+ * functions of apdu.h. Read responses point into payload.
+ * @param tlv Pointer to the array of I2C commands receiving the status words and read responses
+ * @param sz_tlv Size of the tlv array
+ * @param payload Encoded I2CM responses (e.g. attestation_t.data)
+ * @param offset Offset of the first response in payload, moved after the last parsed response on success
+ * @returns APDU_ERROR if responses do not match the commands or are truncated
+ */
+apdu_status_t se050_i2cm_getRsps(i2cm_tlv_t *tlv, uint8_t sz_tlv,
+		const phNxpEse_data *payload, uint32_t *offset);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_APDU_INTERNAL_H_ */
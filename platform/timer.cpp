@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "timer.h"
+#include "mbed.h"
+
+uint32_t se050_timer_us(void)
+{
+	return us_ticker_read();
+}
+
+void se050_timer_sleepUntil(uint32_t deadline)
+{
+	int32_t remaining = (int32_t)(deadline - se050_timer_us());
+
+	if(remaining > 1000)
+		thread_sleep_for((remaining - 1000) / 1000);
+	remaining = (int32_t)(deadline - se050_timer_us());
+	if(remaining > 0)
+		wait_us(remaining);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MBED_SE050_DRV_PLATFORM_TIMER_H_
+#define MBED_SE050_DRV_PLATFORM_TIMER_H_
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"{
+#endif
+
+/**
+ * Get the value of a free running microsecond counter. The counter wraps
+ * around every 2^32 microseconds, durations must be computed as unsigned
+ * differences.
+ */
+uint32_t se050_timer_us(void);
+
+/**
+ * Sleep until the microsecond counter reaches deadline. The thread sleeps for
+ * whole milliseconds then busy-waits for the remaining time. Returns
+ * immediately if deadline is already passed.
+ * @param deadline Value of se050_timer_us() to wait for
+ */
+void se050_timer_sleepUntil(uint32_t deadline);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* MBED_SE050_DRV_PLATFORM_TIMER_H_ */
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "worker.h"
+#include "timer.h"
+#include "../se050_power.h"
+#include "../se050_keypool.h"
+#include "mbed.h"
+
+typedef struct {
+	se050_future_t *ring[MBED_CONF_SE050_WORKER_QUEUE_DEPTH];
+	uint32_t head;
+	se050_queueStats_t stats;
+} se050_queue_t;
+
+static Mutex se050_workerMutex;
+static ConditionVariable se050_workerPending(se050_workerMutex);
+static ConditionVariable se050_workerDone(se050_workerMutex);
+static se050_queue_t se050_queues[SE050_PRIO_COUNT];
+static Thread *se050_workerThread;
+static apdu_ctx_t *se050_workerCtx;
+static se050_power_t *se050_workerPower;
+static se050_keypool_t *se050_workerKeypool;
+/// Set when a key generation failed, cleared by the next job
+static bool se050_workerKeypoolFailed;
+/// Value of se050_power_t.wakeups the key pool is up to date with
+static uint32_t se050_workerWakeups;
+
+/// Priority of the running job, SE050_PRIO_COUNT when idle
+static uint32_t se050_workerCurrent = SE050_PRIO_COUNT;
+
+/*
+ * Pop the oldest request of the highest priority above limit.
+ */
+static se050_future_t *popLocked(uint32_t now, uint32_t limit)
+{
+	for (uint32_t p = 0; p < limit; p++) {
+		se050_queue_t *q = &se050_queues[p];
+		if (q->stats.depth == 0)
+			continue;
+
+		se050_future_t *future = q->ring[q->head];
+		q->head = (q->head + 1) % MBED_CONF_SE050_WORKER_QUEUE_DEPTH;
+		q->stats.depth--;
+
+		uint32_t wait = now - future->submitted;
+		q->stats.waitSum += wait;
+		if (wait > q->stats.waitMax)
+			q->stats.waitMax = wait;
+		return future;
+	}
+	return NULL;
+}
+
+/*
+ * Power the SE050 up if needed. Key pair values of the key pool are lost
+ * by a power cycle, so the pool is reset after each wakeup.
+ */
+static apdu_status_t acquirePower(void)
+{
+	if (se050_workerPower == NULL)
+		return APDU_OK;
+	if (se050_power_acquire(se050_workerPower) != APDU_OK)
+		return APDU_ERROR;
+	if (se050_workerPower->wakeups != se050_workerWakeups) {
+		se050_workerWakeups = se050_workerPower->wakeups;
+		if (se050_workerKeypool != NULL)
+			se050_keypool_reset(se050_workerKeypool);
+	}
+	return APDU_OK;
+}
+
+/*
+ * Run a popped request. Called with the mutex unlocked.
+ */
+static void runJob(se050_future_t *future)
+{
+	uint32_t previous = se050_workerCurrent;
+
+	apdu_status_t status = APDU_ERROR;
+	if (acquirePower() == APDU_OK) {
+		se050_workerCurrent = future->prio;
+		status = future->job(se050_workerCtx, future->arg);
+		se050_workerCurrent = previous;
+		if (se050_workerPower != NULL)
+			se050_power_release(se050_workerPower);
+	}
+
+	se050_workerKeypoolFailed = false;
+
+	se050_workerMutex.lock();
+	se050_queueStats_t *stats = &se050_queues[future->prio].stats;
+	uint32_t latency = se050_timer_us() - future->submitted;
+	if (latency > stats->latencyMax)
+		stats->latencyMax = latency;
+	stats->completed++;
+	future->status = status;
+	__atomic_store_n(&future->state, SE050_FUTURE_DONE, __ATOMIC_RELEASE);
+	se050_workerDone.notify_all();
+	se050_workerMutex.unlock();
+}
+
+/*
+ * Yield hook: serve requests of higher priority than the running job. Nesting
+ * is bounded by the number of priorities.
+ */
+static void workerYield(apdu_ctx_t *ctx, void *arg)
+{
+	if (se050_workerThread == NULL || ThisThread::get_id() != se050_workerThread->get_id())
+		return;
+
+	for (;;) {
+		se050_workerMutex.lock();
+		se050_future_t *future = popLocked(se050_timer_us(), se050_workerCurrent);
+		if (future == NULL) {
+			se050_workerMutex.unlock();
+			return;
+		}
+		se050_queues[future->prio].stats.preemptions++;
+		__atomic_store_n(&future->state, SE050_FUTURE_RUNNING, __ATOMIC_RELEASE);
+		se050_workerMutex.unlock();
+
+		runJob(future);
+	}
+}
+
+/*
+ * Generate one missing key pair of the key pool. A powered off SE050 is not
+ * woken up, since its transient key values would be lost again at the next
+ * power down. Called with the mutex unlocked, returns false if there is
+ * nothing to do.
+ */
+static bool refillKeypool(void)
+{
+	if (se050_workerKeypool == NULL || se050_workerKeypoolFailed
+			|| !se050_keypool_needsRefill(se050_workerKeypool))
+		return false;
+	if (se050_workerPower != NULL && !se050_workerPower->on)
+		return false;
+
+	apdu_status_t status = APDU_ERROR;
+	if (acquirePower() == APDU_OK) {
+		status = se050_keypool_idle(se050_workerKeypool, se050_workerCtx);
+		if (se050_workerPower != NULL)
+			se050_power_release(se050_workerPower);
+	}
+	/* do not retry before the next job */
+	if (status != APDU_OK)
+		se050_workerKeypoolFailed = true;
+	return true;
+}
+
+static void workerMain(void)
+{
+	for (;;) {
+		se050_future_t *future;
+
+		se050_workerMutex.lock();
+		while ((future = popLocked(se050_timer_us(), SE050_PRIO_COUNT)) == NULL) {
+			uint32_t delay = 0;
+			bool refilled = false;
+
+			if (se050_workerPower != NULL || se050_workerKeypool != NULL) {
+				/* the SE050 may be used or switched off, do not hold the queues meanwhile */
+				se050_workerMutex.unlock();
+				refilled = refillKeypool();
+				if (!refilled && se050_workerPower != NULL)
+					delay = se050_power_idle(se050_workerPower);
+				se050_workerMutex.lock();
+				if ((future = popLocked(se050_timer_us(), SE050_PRIO_COUNT)) != NULL)
+					break;
+			}
+			if (refilled)
+				continue;
+			if (delay > 0)
+				se050_workerPending.wait_for(delay);
+			else
+				se050_workerPending.wait();
+		}
+		__atomic_store_n(&future->state, SE050_FUTURE_RUNNING, __ATOMIC_RELEASE);
+		se050_workerMutex.unlock();
+
+		runJob(future);
+	}
+}
+
+apdu_status_t se050_worker_start(apdu_ctx_t *ctx)
+{
+	if (se050_workerThread != NULL)
+		return APDU_ERROR;
+
+	se050_workerCtx = ctx;
+	se050_setYieldHook(workerYield, NULL);
+	se050_workerThread = new Thread(osPriorityAboveNormal, MBED_CONF_SE050_WORKER_STACK_SIZE,
+			NULL, "se050");
+	if (se050_workerThread->start(callback(workerMain)) != osOK) {
+		delete se050_workerThread;
+		se050_workerThread = NULL;
+		return APDU_ERROR;
+	}
+	return APDU_OK;
+}
+
+void se050_worker_setPower(struct se050_power *pm)
+{
+	se050_workerPower = pm;
+	se050_workerWakeups = (pm != NULL) ? pm->wakeups : 0;
+}
+
+void se050_worker_setKeypool(struct se050_keypool *pool)
+{
+	se050_workerKeypool = pool;
+}
+
+apdu_status_t se050_worker_submit(se050_future_t *future, se050_priority_t prio,
+		se050_job_t job, void *arg)
+{
+	if (se050_workerThread == NULL || prio >= SE050_PRIO_COUNT)
+		return APDU_ERROR;
+
+	se050_queue_t *q = &se050_queues[prio];
+	se050_workerMutex.lock();
+	if (q->stats.depth == MBED_CONF_SE050_WORKER_QUEUE_DEPTH) {
+		q->stats.rejected++;
+		se050_workerMutex.unlock();
+		return APDU_ERROR;
+	}
+
+	future->job = job;
+	future->arg = arg;
+	future->prio = prio;
+	future->submitted = se050_timer_us();
+	future->status = APDU_ERROR;
+	future->state = SE050_FUTURE_PENDING;
+
+	q->ring[(q->head + q->stats.depth) % MBED_CONF_SE050_WORKER_QUEUE_DEPTH] = future;
+	q->stats.depth++;
+	q->stats.submitted++;
+	if (q->stats.depth > q->stats.maxDepth)
+		q->stats.maxDepth = q->stats.depth;
+	se050_workerPending.notify_one();
+	se050_workerMutex.unlock();
+	return APDU_OK;
+}
+
+bool se050_future_done(const se050_future_t *future)
+{
+	return __atomic_load_n(&future->state, __ATOMIC_ACQUIRE) == SE050_FUTURE_DONE;
+}
+
+apdu_status_t se050_future_wait(se050_future_t *future)
+{
+	apdu_status_t status;
+
+	se050_workerMutex.lock();
+	while (future->state != SE050_FUTURE_DONE)
+		se050_workerDone.wait();
+	status = future->status;
+	se050_workerMutex.unlock();
+	return status;
+}
+
+apdu_status_t se050_worker_call(se050_priority_t prio, se050_job_t job, void *arg)
+{
+	se050_future_t future;
+
+	if (se050_worker_submit(&future, prio, job, arg) != APDU_OK)
+		return APDU_ERROR;
+	return se050_future_wait(&future);
+}
+
+void se050_worker_getStats(se050_priority_t prio, se050_queueStats_t *stats)
+{
+	se050_workerMutex.lock();
+	*stats = se050_queues[prio].stats;
+	se050_workerMutex.unlock();
+}
+
+void se050_worker_resetStats(void)
+{
+	se050_workerMutex.lock();
+	for (uint32_t p = 0; p < SE050_PRIO_COUNT; p++) {
+		uint32_t depth = se050_queues[p].stats.depth;
+		memset(&se050_queues[p].stats, 0, sizeof(se050_queueStats_t));
+		se050_queues[p].stats.depth = depth;
+		se050_queues[p].stats.maxDepth = depth;
+	}
+	se050_workerMutex.unlock();
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MBED_SE050_DRV_PLATFORM_WORKER_H_
+#define MBED_SE050_DRV_PLATFORM_WORKER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../apdu.h"
+
+#if defined(__cplusplus)
+extern "C"{
+#endif
+
+#ifndef MBED_CONF_SE050_WORKER_QUEUE_DEPTH
+#define MBED_CONF_SE050_WORKER_QUEUE_DEPTH 4
+#endif
+
+#ifndef MBED_CONF_SE050_WORKER_STACK_SIZE
+#define MBED_CONF_SE050_WORKER_STACK_SIZE 4096
+#endif
+
+/**
+ * Priority of a request. Pending requests are served strictly by priority,
+ * then in submission order. A streaming operation (see se050_setYieldHook())
+ * run by a job lets pending requests of higher priority go in between two of
+ * its APDUs: a SE050_PRIO_HIGH request waits at most for one APDU of a lower
+ * priority job, plus the SE050_PRIO_HIGH requests queued before it. Such
+ * requests run within the session of the suspended job: their end of sessions
+ * are deferred until it resumes, and se050_mac_oneShot() uses its own crypto
+ * object for each nesting level. Jobs running multi-step MAC computations with
+ * se050_mac_init() must use crypto objects of their own.
+ */
+typedef enum {
+	SE050_PRIO_HIGH = 0,
+	SE050_PRIO_NORMAL,
+	SE050_PRIO_LOW,
+	SE050_PRIO_COUNT
+} se050_priority_t;
+
+/**
+ * State of a future.
+ */
+typedef enum {
+	SE050_FUTURE_IDLE = 0,
+	SE050_FUTURE_PENDING,
+	SE050_FUTURE_RUNNING,
+	SE050_FUTURE_DONE
+} se050_futureState_t;
+
+/**
+ * Job run by the worker thread. A job may issue any number of commands of the
+ * apdu.h API on ctx, they are not interleaved with commands of other jobs.
+ * @param ctx APDU context owned by the worker
+ * @param arg Argument given to se050_worker_submit()
+ */
+typedef apdu_status_t (*se050_job_t)(apdu_ctx_t *ctx, void *arg);
+
+/**
+ * Future of a request. The future is owned by the caller and must stay valid
+ * until it is done.
+ */
+typedef struct {
+	/// Job to run
+	se050_job_t job;
+	/// Argument of the job
+	void *arg;
+	/// Priority of the request
+	se050_priority_t prio;
+	/// Submission time (se050_timer_us() value)
+	uint32_t submitted;
+	/// se050_futureState_t value, updated by the worker
+	uint32_t state;
+	/// Return value of the job, valid once done
+	apdu_status_t status;
+} se050_future_t;
+
+/**
+ * Statistics of a priority queue.
+ */
+typedef struct {
+	/// Current number of pending requests
+	uint32_t depth;
+	/// Maximum number of pending requests
+	uint32_t maxDepth;
+	/// Number of accepted requests
+	uint32_t submitted;
+	/// Number of requests rejected because the queue was full
+	uint32_t rejected;
+	/// Number of completed requests
+	uint32_t completed;
+	/// Maximum time spent in the queue in microseconds
+	uint32_t waitMax;
+	/// Sum of times spent in the queue in microseconds
+	uint64_t waitSum;
+	/// Maximum time between submission and completion in microseconds
+	uint32_t latencyMax;
+	/// Number of requests run between two APDUs of a lower priority job
+	uint32_t preemptions;
+} se050_queueStats_t;
+
+/**
+ * Start the worker thread and install its yield hook. The worker becomes the only user of ctx: once
+ * started, other threads must access the SE050 through se050_worker_submit()
+ * or se050_worker_call() only.
+ * @param ctx Connected APDU context
+ * @returns APDU_ERROR if the worker is already started or the thread cannot be created
+ */
+apdu_status_t se050_worker_start(apdu_ctx_t *ctx);
+
+struct se050_power;
+
+/**
+ * Let the worker manage the power of the SE050: the SE050 is powered and
+ * selected before each job (see se050_power_acquire()) and switched off once
+ * idle. Must be called before se050_worker_start().
+ * @param pm Initialized power manager of the worker context, NULL to disable
+ */
+void se050_worker_setPower(struct se050_power *pm);
+
+struct se050_keypool;
+
+/**
+ * Let the worker refill a key pool: while its queues are empty and the SE050
+ * is powered, the worker generates the missing key pairs one at a time (see
+ * se050_keypool_idle()). A request arriving meanwhile waits for at most one
+ * key generation. The pool is reset after each wakeup of the power manager
+ * (see se050_worker_setPower()), since key pair values do not survive power
+ * cycles. The pool must then be used from jobs only. Must be called before
+ * se050_worker_start().
+ * @param pool Initialized key pool, NULL to disable
+ */
+void se050_worker_setKeypool(struct se050_keypool *pool);
+
+/**
+ * Queue a job. Never blocks.
+ * @param future Caller-owned future, must not be pending
+ * @param prio Priority of the request
+ * @param job Job to run on the worker thread
+ * @param arg Argument of the job
+ * @returns APDU_ERROR if the worker is not started or the queue of prio is full
+ */
+apdu_status_t se050_worker_submit(se050_future_t *future, se050_priority_t prio,
+		se050_job_t job, void *arg);
+
+/**
+ * Poll a future.
+ * @returns true once the job has returned
+ */
+bool se050_future_done(const se050_future_t *future);
+
+/**
+ * Block until the job of a future has returned.
+ * @returns Return value of the job
+ */
+apdu_status_t se050_future_wait(se050_future_t *future);
+
+/**
+ * Queue a job and wait for its result.
+ * @returns Return value of the job, or APDU_ERROR if it cannot be queued
+ */
+apdu_status_t se050_worker_call(se050_priority_t prio, se050_job_t job, void *arg);
+
+/**
+ * Get a snapshot of the statistics of a priority queue.
+ */
+void se050_worker_getStats(se050_priority_t prio, se050_queueStats_t *stats);
+
+/**
+ * Reset the statistics of all queues, except current depths.
+ */
+void se050_worker_resetStats(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* MBED_SE050_DRV_PLATFORM_WORKER_H_ */
@@ -9,6 +9,19 @@
 #define MBED_SE050_DRV_PLATFORM_SE050_H_
 
 #include "apdu.h"
+#include "se050_dir.h"
+#include "se050_pkcache.h"
+#include "se050_keypool.h"
+#include "se050_sampler.h"
+#include "se050_scheduler.h"
+#include "se050_verify.h"
+#include "se050_record.h"
+#include "se050_freshness.h"
+#include "se050_challenge.h"
+#include "se050_power.h"
+#include "se050_powerlog.h"
 #include "platform/reset.h"
+#include "platform/timer.h"
+#include "platform/worker.h"
 
 #endif /* MBED_SE050_DRV_PLATFORM_SE050_H_ */
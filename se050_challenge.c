@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_challenge.h"
+#include <string.h>
+
+static void setCounter(uint8_t *buff, uint32_t counter) {
+	buff[0] = (counter & 0xFF000000) >> 24;
+	buff[1] = (counter & 0x00FF0000) >> 16;
+	buff[2] = (counter & 0x0000FF00) >> 8;
+	buff[3] = (counter & 0x000000FF);
+}
+
+apdu_status_t se050_challenge_init(se050_challenge_t *provider,
+		const uint8_t *seed, uint32_t len, uint32_t counter) {
+
+	memset(provider, 0, sizeof(se050_challenge_t));
+	mbedtls_md_init(&provider->hmac);
+	if (mbedtls_md_setup(&provider->hmac,
+			mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1) != 0
+			|| mbedtls_md_hmac_starts(&provider->hmac, seed, len) != 0) {
+		mbedtls_md_free(&provider->hmac);
+		return APDU_ERROR;
+	}
+	provider->counter = counter;
+	return APDU_OK;
+}
+
+apdu_status_t se050_challenge_initFromSE(se050_challenge_t *provider,
+		apdu_ctx_t *ctx) {
+
+	uint8_t seed[32];
+	apdu_status_t status;
+
+	if (se050_getRandom(&seed[0], sizeof(seed), ctx) != APDU_OK)
+		return APDU_ERROR;
+	status = se050_challenge_init(provider, &seed[0], sizeof(seed), 0);
+	memset(&seed[0], 0, sizeof(seed));
+	return status;
+}
+
+void se050_challenge_free(se050_challenge_t *provider) {
+	mbedtls_md_free(&provider->hmac);
+	memset(provider, 0, sizeof(se050_challenge_t));
+}
+
+apdu_status_t se050_challenge_refill(se050_challenge_t *provider) {
+
+	uint8_t input[4];
+	uint8_t mac[32];
+
+	uint8_t count = 0;
+
+	if (provider->index < provider->count)
+		return APDU_OK;
+	if (provider->exhausted)
+		return APDU_ERROR;
+
+	provider->batchCounter = provider->counter;
+	while (count < MBED_CONF_SE050_CHALLENGE_BATCH && !provider->exhausted) {
+		setCounter(&input[0], provider->counter);
+		/* the key set by hmac_starts is kept by hmac_reset */
+		if (mbedtls_md_hmac_reset(&provider->hmac) != 0
+				|| mbedtls_md_hmac_update(&provider->hmac, &input[0], 4) != 0
+				|| mbedtls_md_hmac_finish(&provider->hmac, &mac[0]) != 0) {
+			provider->count = 0;
+			provider->index = 0;
+			provider->counter = provider->batchCounter;
+			provider->exhausted = false;
+			return APDU_ERROR;
+		}
+		memcpy(&provider->batch[count++][0], &mac[0], 16);
+		/* challenges would repeat once the counter wraps */
+		if (++provider->counter == 0)
+			provider->exhausted = true;
+	}
+	provider->count = count;
+	provider->index = 0;
+	return APDU_OK;
+}
+
+apdu_status_t se050_challenge_next(se050_challenge_t *provider,
+		uint8_t *random, uint32_t *counter) {
+
+	if (se050_challenge_refill(provider) != APDU_OK)
+		return APDU_ERROR;
+	memcpy(random, &provider->batch[provider->index][0], 16);
+	if (counter != NULL)
+		*counter = provider->batchCounter + provider->index;
+	provider->index++;
+	return APDU_OK;
+}
+
+apdu_status_t se050_challenge_compute(const uint8_t *seed, uint32_t len,
+		uint32_t counter, uint8_t *random) {
+
+	uint8_t input[4];
+	uint8_t mac[32];
+
+	setCounter(&input[0], counter);
+	if (mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), seed,
+			len, &input[0], 4, &mac[0]) != 0)
+		return APDU_ERROR;
+	memcpy(random, &mac[0], 16);
+	return APDU_OK;
+}
+
+apdu_status_t se050_challenge_source(uint8_t *random, void *arg) {
+	return se050_challenge_next((se050_challenge_t*) arg, random, NULL);
+}
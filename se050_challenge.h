@@ -0,0 +1,139 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_CHALLENGE_H_
+#define SE050_DRV_CHALLENGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+#include "mbedtls/md.h"
+
+/**
+ * @file se050_challenge.h
+ * @author Michael Grand
+ *
+ * Provider of the 16-byte randoms sent with attested commands. Challenges
+ * are derived from a 32-byte seed and a 32-bit counter:
+ *
+ *     challenge_n = HMAC-SHA256(seed, n)[0..15]    (n encoded big endian)
+ *
+ * The seed is either issued by a server, which can then compute the expected
+ * challenge of each attestation from its counter without exchanging
+ * messages, or drawn from the SE050 random number generator.
+ *
+ * Challenges are computed by batches of MBED_CONF_SE050_CHALLENGE_BATCH,
+ * either on demand or ahead of time with se050_challenge_refill(). Once the
+ * challenge of counter 0xFFFFFFFF has been computed, the provider refuses to
+ * compute more challenges, since they would repeat: it must be initialized
+ * again with a new seed.
+ */
+
+#ifndef MBED_CONF_SE050_CHALLENGE_BATCH
+#define MBED_CONF_SE050_CHALLENGE_BATCH 8
+#endif
+
+/**
+ * Challenge provider state.
+ */
+typedef struct {
+	/// HMAC context keyed with the seed
+	mbedtls_md_context_t hmac;
+	/// Counter of the next challenge to compute
+	uint32_t counter;
+	/// Precomputed challenges
+	uint8_t batch[MBED_CONF_SE050_CHALLENGE_BATCH][16];
+	/// Counter of the first precomputed challenge
+	uint32_t batchCounter;
+	/// Number of precomputed challenges
+	uint8_t count;
+	/// Index of the next precomputed challenge
+	uint8_t index;
+	/// Set once the counter has wrapped, a new seed is then required
+	bool exhausted;
+} se050_challenge_t;
+
+/**
+ * Initialize a challenge provider with a seed.
+ * @param provider Pointer to a provider structure
+ * @param seed Pointer to the seed (e.g. issued by a server)
+ * @param len Length of the seed
+ * @param counter Counter of the first challenge
+ * @returns APDU_ERROR if HMAC-SHA256 is not available
+ */
+apdu_status_t se050_challenge_init(se050_challenge_t *provider,
+		const uint8_t *seed, uint32_t len, uint32_t counter);
+
+/**
+ * Initialize a challenge provider with a 32-byte seed drawn from the SE050.
+ * @param provider Pointer to a provider structure
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the provider has been initialized
+ */
+apdu_status_t se050_challenge_initFromSE(se050_challenge_t *provider,
+		apdu_ctx_t *ctx);
+
+/**
+ * Release resources used by a challenge provider.
+ * @param provider Pointer to an initialized provider structure
+ */
+void se050_challenge_free(se050_challenge_t *provider);
+
+/**
+ * Compute the next batch of challenges if all precomputed ones have been used.
+ * The last batch before the counter wraps may be shorter.
+ * @param provider Pointer to an initialized provider structure
+ * @returns APDU_ERROR if HMAC computation fails or if the counter has wrapped
+ */
+apdu_status_t se050_challenge_refill(se050_challenge_t *provider);
+
+/**
+ * Get the next challenge.
+ * @param provider Pointer to an initialized provider structure
+ * @param random Buffer receiving the 16-byte challenge
+ * @param counter Pointer receiving the counter of the challenge, may be NULL
+ * @returns APDU_ERROR if HMAC computation fails or if the counter has wrapped
+ */
+apdu_status_t se050_challenge_next(se050_challenge_t *provider,
+		uint8_t *random, uint32_t *counter);
+
+/**
+ * Compute a single challenge, e.g. on the server to check an attestation.
+ * @param seed Pointer to the seed
+ * @param len Length of the seed
+ * @param counter Counter of the challenge
+ * @param random Buffer receiving the 16-byte challenge
+ * @returns APDU_ERROR if HMAC computation fails
+ */
+apdu_status_t se050_challenge_compute(const uint8_t *seed, uint32_t len,
+		uint32_t counter, uint8_t *random);
+
+/**
+ * Random source callback (see se050_scheduler.h) taking its challenges from
+ * the provider given as argument.
+ * @param random Buffer receiving the 16-byte challenge
+ * @param arg Pointer to an initialized provider structure
+ * @returns APDU_ERROR if no challenge can be computed, see se050_challenge_next()
+ */
+apdu_status_t se050_challenge_source(uint8_t *random, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_CHALLENGE_H_ */
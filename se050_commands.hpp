@@ -0,0 +1,263 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_COMMANDS_HPP_
+#define SE050_DRV_COMMANDS_HPP_
+
+/**
+ * @file se050_commands.hpp
+ * @author Michael Grand
+ *
+ * Optional C++ layer describing SE050 commands at compile time. A command
+ * descriptor holds its header bytes and the TLV layout of its data and
+ * response as constant expressions: headers are placed in read-only memory,
+ * nothing is set up at runtime, and a command whose worst-case encoding does
+ * not fit in the APDU buffer is rejected by the compiler.
+ *
+ * Commands are sent through se050_sendCommand(), the C API of apdu.h is left
+ * unchanged. Commands creating, writing or deleting objects are not described
+ * here: they must go through apdu.c, which records them in the object change
+ * journal (see se050_getObjChange()).
+ *
+ * tools/commands compiles these descriptors and runs them against the
+ * simulated SE050.
+ *
+ * Example:
+ * @code
+ *	#include "se050_commands.hpp"
+ *
+ *	apdu_status_t readType(uint32_t objId, uint8_t *type, apdu_ctx_t *ctx) {
+ *		se050::Encoder<se050::cmd::ReadType> enc(ctx);
+ *		enc.put<0>(objId);
+ *		se050::Decoder<se050::cmd::ReadType> dec;
+ *		if (enc.send(ctx) != APDU_OK || dec.parse(ctx) != APDU_OK)
+ *			return APDU_ERROR;
+ *		return dec.get<0>(type);
+ *	}
+ * @endcode
+ */
+
+#include <stddef.h>
+#include "apdu.h"
+#include "se050_tlv.h"
+
+namespace se050 {
+
+/**
+ * Length of a BER-TLV whose value is at most len bytes long.
+ */
+constexpr uint32_t tlvLen(uint32_t len) {
+	return ((len > 0xFF) ? 4 : (len > 0x7F) ? 3 : 2) + len;
+}
+
+/**
+ * TLV field descriptor.
+ * @tparam TAG Tag of the field
+ * @tparam MAX_LEN Maximum length of the value
+ */
+template<SE050_TAG_t TAG, uint32_t MAX_LEN>
+struct Tlv {
+	static constexpr SE050_TAG_t tag = TAG;
+	static constexpr uint32_t maxLen = MAX_LEN;
+	static constexpr uint32_t maxEncodedLen = tlvLen(MAX_LEN);
+};
+
+/**
+ * Ordered list of TLV fields.
+ */
+template<typename ... FIELDS>
+struct Layout;
+
+template<>
+struct Layout<> {
+	static constexpr uint32_t count = 0;
+	static constexpr uint32_t maxEncodedLen = 0;
+};
+
+template<typename FIRST, typename ... OTHERS>
+struct Layout<FIRST, OTHERS...> {
+	static constexpr uint32_t count = 1 + Layout<OTHERS...>::count;
+	static constexpr uint32_t maxEncodedLen = FIRST::maxEncodedLen
+			+ Layout<OTHERS...>::maxEncodedLen;
+};
+
+/**
+ * Get the Nth field of a layout.
+ */
+template<uint32_t N, typename LAYOUT>
+struct FieldAt;
+
+template<typename FIRST, typename ... OTHERS>
+struct FieldAt<0, Layout<FIRST, OTHERS...> > {
+	typedef FIRST type;
+};
+
+template<uint32_t N, typename FIRST, typename ... OTHERS>
+struct FieldAt<N, Layout<FIRST, OTHERS...> > {
+	typedef typename FieldAt<N - 1, Layout<OTHERS...> >::type type;
+};
+
+/**
+ * Command descriptor.
+ * @tparam INS Instruction byte
+ * @tparam P1 P1 byte
+ * @tparam P2 P2 byte
+ * @tparam DATA Layout of command data
+ * @tparam RSP Layout of the response
+ */
+template<uint8_t INS, uint8_t P1, uint8_t P2, typename DATA, typename RSP>
+struct Command {
+	typedef DATA data;
+	typedef RSP response;
+
+	static constexpr uint8_t header[4] = { 0x80, INS, P1, P2 };
+
+	static_assert(DATA::maxEncodedLen <= APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2,
+			"command data do not fit in the APDU buffer");
+	static_assert(RSP::maxEncodedLen <= APDU_BUFF_SZ - 2,
+			"response does not fit in the APDU buffer");
+
+	/// Expected response length, used as Le
+	static constexpr uint32_t le = RSP::maxEncodedLen;
+};
+
+template<uint8_t INS, uint8_t P1, uint8_t P2, typename DATA, typename RSP>
+constexpr uint8_t Command<INS, P1, P2, DATA, RSP>::header[4];
+
+/**
+ * Encoder of the data of a command. Fields are written in the APDU buffer
+ * after the room kept for the header.
+ */
+template<typename CMD>
+class Encoder {
+public:
+	explicit Encoder(apdu_ctx_t *ctx) {
+		se050_tlv_initWriter(&_w, &ctx->buff[APDU_HDR_MAX_SZ],
+				APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2);
+	}
+
+	/// Write the Nth field as a 1, 2 or 4-byte integer, depending on its maximum length
+	template<uint32_t N>
+	void put(uint32_t value) {
+		typedef typename FieldAt<N, typename CMD::data>::type field;
+		static_assert(field::maxLen == 1 || field::maxLen == 2
+				|| field::maxLen == 4, "field is not an integer");
+		if (field::maxLen == 1)
+			se050_tlv_putU8(&_w, field::tag, value);
+		else if (field::maxLen == 2)
+			se050_tlv_putU16(&_w, field::tag, value);
+		else
+			se050_tlv_putU32(&_w, field::tag, value);
+	}
+
+	/// Write the Nth field as an array, rejected if longer than its maximum length
+	template<uint32_t N>
+	void put(const uint8_t *data, uint32_t len) {
+		typedef typename FieldAt<N, typename CMD::data>::type field;
+		if (len > field::maxLen)
+			_w.overflow = true;
+		else
+			se050_tlv_putArray(&_w, field::tag, data, len);
+	}
+
+	/// Send the command
+	apdu_status_t send(apdu_ctx_t *ctx) {
+		uint32_t len;
+		if (!se050_tlv_finish(&_w, &len))
+			return APDU_ERROR;
+		return se050_sendCommand(&CMD::header[0], len, CMD::le, ctx);
+	}
+
+private:
+	se050_tlvWriter_t _w;
+};
+
+/**
+ * Decoder of the response of a command.
+ */
+template<typename CMD>
+class Decoder {
+public:
+	/// Parse the current response
+	apdu_status_t parse(apdu_ctx_t *ctx) {
+		if (!se050_tlv_decode(&_view, ctx->out.p_data, ctx->out.len))
+			return APDU_ERROR;
+		return APDU_OK;
+	}
+
+	/// Get the value of the Nth field of the response
+	template<uint32_t N>
+	apdu_status_t get(phNxpEse_data *value) const {
+		typedef typename FieldAt<N, typename CMD::response>::type field;
+		if (!se050_tlv_get(&_view, field::tag, value) || value->len > field::maxLen)
+			return APDU_ERROR;
+		return APDU_OK;
+	}
+
+	/// Get the Nth field of the response as a 1-byte value
+	template<uint32_t N>
+	apdu_status_t get(uint8_t *value) const {
+		typedef typename FieldAt<N, typename CMD::response>::type field;
+		static_assert(field::maxLen == 1, "field is not a 1-byte value");
+		phNxpEse_data data;
+		if (get<N>(&data) != APDU_OK || data.len != 1)
+			return APDU_ERROR;
+		*value = data.p_data[0];
+		return APDU_OK;
+	}
+
+private:
+	se050_tlvView_t _view;
+};
+
+/**
+ * Descriptors of SE050 commands.
+ */
+namespace cmd {
+
+/// Identifier of the attestation key used by attested I2CM commands
+constexpr uint32_t I2CM_ATTESTATION_KEY_ID = 0xF0000012;
+
+typedef Command<SE050_INS_READ, SE050_P1_DEFAULT, SE050_P2_TYPE,
+		Layout<Tlv<SE050_TAG_1, 4> >,
+		Layout<Tlv<SE050_TAG_1, 1>, Tlv<SE050_TAG_2, 1> > > ReadType;
+
+typedef Command<SE050_INS_READ, SE050_P1_DEFAULT, SE050_P2_SIZE,
+		Layout<Tlv<SE050_TAG_1, 4> >,
+		Layout<Tlv<SE050_TAG_1, 2> > > ReadSize;
+
+typedef Command<SE050_INS_MGMT, SE050_P1_DEFAULT, SE050_P2_EXIST,
+		Layout<Tlv<SE050_TAG_1, 4> >,
+		Layout<Tlv<SE050_TAG_1, 1> > > CheckObjectExists;
+
+typedef Command<SE050_INS_READ, SE050_P1_DEFAULT, SE050_P2_LIST,
+		Layout<Tlv<SE050_TAG_1, 2>, Tlv<SE050_TAG_2, 1> >,
+		Layout<Tlv<SE050_TAG_1, 1>, Tlv<SE050_TAG_2, APDU_BUFF_SZ - 2 - 3 - 4> > > ReadIDList;
+
+typedef Command<SE050_INS_MGMT, SE050_P1_DEFAULT, SE050_P2_RANDOM,
+		Layout<Tlv<SE050_TAG_1, 2> >,
+		Layout<Tlv<SE050_TAG_1, SE050_RANDOM_MAX_LEN> > > GetRandom;
+
+typedef Command<SE050_INS_CRYPTO, SE050_P1_MAC, SE050_P2_GENERATE_ONESHOT,
+		Layout<Tlv<SE050_TAG_1, 4>, Tlv<SE050_TAG_2, 1>,
+				Tlv<SE050_TAG_3, SE050_MAC_ONESHOT_MAX_DATA> >,
+		Layout<Tlv<SE050_TAG_1, 64> > > MACOneShot;
+
+} // namespace cmd
+} // namespace se050
+
+#endif /* SE050_DRV_COMMANDS_HPP_ */
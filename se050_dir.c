@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_dir.h"
+#include <string.h>
+
+#define DIR_FILTER_ALL 0xFF
+
+static se050_dirEntry_t *findEntry(se050_dir_t *dir, uint32_t objId) {
+
+	int32_t lo = 0;
+	int32_t hi = dir->count - 1;
+	while (lo <= hi) {
+		int32_t mid = (lo + hi) / 2;
+		if (dir->entries[mid].id == objId)
+			return &dir->entries[mid];
+		if (dir->entries[mid].id < objId)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return NULL;
+}
+
+static void insertSorted(se050_dir_t *dir, uint32_t objId, uint8_t type) {
+
+	uint16_t k = dir->count;
+	while (k > 0 && dir->entries[k - 1].id > objId) {
+		dir->entries[k] = dir->entries[k - 1];
+		k--;
+	}
+	dir->entries[k].id = objId;
+	dir->entries[k].type = type;
+	dir->count++;
+}
+
+static void removeEntry(se050_dir_t *dir, se050_dirEntry_t *entry) {
+
+	uint16_t k = entry - dir->entries;
+	memmove(entry, entry + 1, (dir->count - k - 1) * sizeof(se050_dirEntry_t));
+	dir->count--;
+}
+
+/*
+ * Update the cache with a change made by this driver.
+ */
+static void applyChange(se050_dir_t *dir, const se050_objChange_t *change) {
+
+	se050_dirEntry_t *entry = findEntry(dir, change->objId);
+
+	switch (change->kind) {
+	case SE050_OBJ_CREATED:
+		if (entry != NULL)
+			entry->type = change->type;
+		else if (dir->count < MBED_CONF_SE050_DIR_CACHE_SIZE)
+			insertSorted(dir, change->objId, change->type);
+		else
+			dir->complete = false;
+		break;
+	case SE050_OBJ_DELETED:
+		if (entry != NULL)
+			removeEntry(dir, entry);
+		break;
+	default:
+		/* the list of objects is unchanged */
+		break;
+	}
+}
+
+/*
+ * Replay the changes journaled since the last lookup. The list is read again
+ * only if one of them is unknown or no longer journaled.
+ */
+static apdu_status_t checkUpToDate(se050_dir_t *dir, apdu_ctx_t *ctx) {
+
+	se050_objChange_t change;
+
+	if (!dir->valid)
+		return se050_dir_refresh(dir, ctx);
+	while (dir->generation != ctx->objGeneration) {
+		if (!se050_getObjChange(dir->generation + 1, &change, ctx)
+				|| change.kind == SE050_OBJ_UNKNOWN)
+			return se050_dir_refresh(dir, ctx);
+		applyChange(dir, &change);
+		dir->generation++;
+	}
+	return APDU_OK;
+}
+
+void se050_dir_init(se050_dir_t *dir) {
+	memset(dir, 0, sizeof(se050_dir_t));
+}
+
+apdu_status_t se050_dir_refresh(se050_dir_t *dir, apdu_ctx_t *ctx) {
+
+	phNxpEse_data ids;
+	bool more = true;
+	uint16_t offset = 0;
+
+	dir->valid = false;
+	dir->count = 0;
+	dir->complete = true;
+	while (more) {
+		if (se050_readIDList(offset, DIR_FILTER_ALL, &more, &ids, ctx)
+				!= APDU_OK)
+			return APDU_ERROR;
+		if (ids.len % 4 != 0)
+			return APDU_ERROR;
+		for (uint32_t i = 0; i < ids.len; i += 4) {
+			uint32_t objId = (uint32_t) ids.p_data[i] << 24
+					| (uint32_t) ids.p_data[i + 1] << 16
+					| (uint32_t) ids.p_data[i + 2] << 8 | ids.p_data[i + 3];
+			if (dir->count < MBED_CONF_SE050_DIR_CACHE_SIZE)
+				insertSorted(dir, objId, SE050_SecureObjectType_NA);
+			else
+				dir->complete = false;
+		}
+		offset += ids.len / 4;
+		if (ids.len == 0)
+			break;
+	}
+	dir->generation = ctx->objGeneration;
+	dir->valid = true;
+	return APDU_OK;
+}
+
+apdu_status_t se050_dir_exists(se050_dir_t *dir, uint32_t objId, bool *exists,
+		apdu_ctx_t *ctx) {
+
+	if (checkUpToDate(dir, ctx) != APDU_OK)
+		return APDU_ERROR;
+	if (findEntry(dir, objId) != NULL) {
+		*exists = true;
+		return APDU_OK;
+	}
+	if (dir->complete) {
+		*exists = false;
+		return APDU_OK;
+	}
+	return se050_checkObjectExists(objId, exists, ctx);
+}
+
+apdu_status_t se050_dir_getType(se050_dir_t *dir, uint32_t objId,
+		uint8_t *type, apdu_ctx_t *ctx) {
+
+	se050_dirEntry_t *entry;
+
+	if (checkUpToDate(dir, ctx) != APDU_OK)
+		return APDU_ERROR;
+	entry = findEntry(dir, objId);
+	if (entry == NULL) {
+		if (dir->complete)
+			return APDU_ERROR;
+		return se050_readType(objId, type, ctx);
+	}
+	if (entry->type == SE050_SecureObjectType_NA) {
+		if (se050_readType(objId, &entry->type, ctx) != APDU_OK) {
+			entry->type = SE050_SecureObjectType_NA;
+			return APDU_ERROR;
+		}
+	}
+	*type = entry->type;
+	return APDU_OK;
+}
@@ -0,0 +1,110 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_DIR_H_
+#define SE050_DRV_DIR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_dir.h
+ * @author Michael Grand
+ *
+ * Host-side cache of the list of objects stored in the SE050. The cache is
+ * filled using ReadIDList. Objects created or deleted by this driver update
+ * the cache in place from the object change journal of the APDU context (see
+ * se050_getObjChange()); the list is read again after se050_connect(), after a
+ * lost response or when more changes than the journal holds happened since
+ * the last lookup. Objects created or deleted by another host are not
+ * detected until the next se050_connect().
+ */
+
+#ifndef MBED_CONF_SE050_DIR_CACHE_SIZE
+#define MBED_CONF_SE050_DIR_CACHE_SIZE 32
+#endif
+
+/**
+ * Cached information about an object.
+ */
+typedef struct {
+	/// Object identifier
+	uint32_t id;
+	/// Object type (SE050_SecureObjectType_t), SE050_SecureObjectType_NA if not read yet
+	uint8_t type;
+} se050_dirEntry_t;
+
+/**
+ * Object directory cache.
+ */
+typedef struct {
+	/// Cached objects sorted by identifier
+	se050_dirEntry_t entries[MBED_CONF_SE050_DIR_CACHE_SIZE];
+	/// Number of cached objects
+	uint16_t count;
+	/// False if the SE050 holds more objects than the cache can store
+	bool complete;
+	/// True once the cache has been filled
+	bool valid;
+	/// Value of apdu_ctx_t.objGeneration the cache is up to date with
+	uint32_t generation;
+} se050_dir_t;
+
+/**
+ * Initialize an empty directory cache.
+ * @param dir Pointer to a directory cache structure
+ */
+void se050_dir_init(se050_dir_t *dir);
+
+/**
+ * Unconditionally reload the directory cache from the SE050.
+ * @param dir Pointer to an initialized directory cache structure
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the object list has been read
+ */
+apdu_status_t se050_dir_refresh(se050_dir_t *dir, apdu_ctx_t *ctx);
+
+/**
+ * Check if an object exists. No APDU is sent if the cache is up to date.
+ * @param dir Pointer to an initialized directory cache structure
+ * @param objId Identifier of the object
+ * @param exists Pointer to the result
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the lookup succeeded
+ */
+apdu_status_t se050_dir_exists(se050_dir_t *dir, uint32_t objId, bool *exists,
+		apdu_ctx_t *ctx);
+
+/**
+ * Get the type of an object. The type is read from the SE050 only the first
+ * time it is requested.
+ * @param dir Pointer to an initialized directory cache structure
+ * @param objId Identifier of the object
+ * @param type Pointer to the object type (SE050_SecureObjectType_t)
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the lookup succeeded (APDU_ERROR if the object does not exist)
+ */
+apdu_status_t se050_dir_getType(se050_dir_t *dir, uint32_t objId,
+		uint8_t *type, apdu_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_DIR_H_ */
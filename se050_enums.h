@@ -37,20 +37,45 @@ typedef enum
 
 typedef enum
 {
+    /** Mask for transient object creation. */
+    SE050_INS_TRANSIENT = 0x80,
     /** Mask for getting attestation data. */
     SE050_INS_ATTEST = 0x20,
+    /** Write or create a persistent object. */
+    SE050_INS_WRITE = 0x01,
+    /** Read an object. */
+    SE050_INS_READ = 0x02,
     /** Perform Security Operation */
     SE050_INS_CRYPTO = 0x03,
+    /** General operation */
+    SE050_INS_MGMT = 0x04,
 } SE050_INS_t;
 
 typedef enum
 {
-	SE050_P1_DEFAULT = 0x00
+	SE050_P1_DEFAULT = 0x00,
+	SE050_P1_EC = 0x01,
+	SE050_P1_BINARY = 0x06,
+	SE050_P1_MAC = 0x0D,
+	SE050_P1_CRYPTO_OBJ = 0x10,
+	/** Mask for key pair objects */
+	SE050_P1_KEY_PAIR = 0x60
 } SE050_P1_t;
 
 typedef enum
 {
-    SE050_P2_I2CM = 0x30
+    SE050_P2_DEFAULT = 0x00,
+    SE050_P2_GENERATE = 0x03,
+    SE050_P2_SIZE = 0x07,
+    SE050_P2_UPDATE = 0x0C,
+    SE050_P2_FINAL = 0x0D,
+    SE050_P2_LIST = 0x25,
+    SE050_P2_TYPE = 0x26,
+    SE050_P2_EXIST = 0x27,
+    SE050_P2_DELETE_OBJECT = 0x28,
+    SE050_P2_I2CM = 0x30,
+    SE050_P2_GENERATE_ONESHOT = 0x45,
+    SE050_P2_RANDOM = 0x49
 } SE050_P2_t;
 
 typedef enum
@@ -64,6 +89,43 @@ typedef enum
     SE050_TAG_7 = 0x47
 } SE050_TAG_t;
 
+typedef enum
+{ /** Invalid */
+    SE050_Result_NA = 0,
+    SE050_Result_SUCCESS = 0x01,
+    SE050_Result_FAILURE = 0x02,
+} SE050_Result_t;
+
+typedef enum
+{ /** Invalid */
+    SE050_SecureObjectType_NA = 0,
+    SE050_SecureObjectType_EC_KEY_PAIR = 0x01,
+    SE050_SecureObjectType_EC_PRIV_KEY = 0x02,
+    SE050_SecureObjectType_EC_PUB_KEY = 0x03,
+    SE050_SecureObjectType_RSA_KEY_PAIR = 0x04,
+    SE050_SecureObjectType_RSA_KEY_PAIR_CRT = 0x05,
+    SE050_SecureObjectType_RSA_PRIV_KEY = 0x06,
+    SE050_SecureObjectType_RSA_PRIV_KEY_CRT = 0x07,
+    SE050_SecureObjectType_RSA_PUB_KEY = 0x08,
+    SE050_SecureObjectType_AES_KEY = 0x09,
+    SE050_SecureObjectType_DES_KEY = 0x0A,
+    SE050_SecureObjectType_BINARY_FILE = 0x0B,
+    SE050_SecureObjectType_USERID = 0x0C,
+    SE050_SecureObjectType_COUNTER = 0x0D,
+    SE050_SecureObjectType_PCR = 0x0F,
+    SE050_SecureObjectType_CURVE = 0x10,
+    SE050_SecureObjectType_HMAC_KEY = 0x11,
+} SE050_SecureObjectType_t;
+
+typedef enum
+{ /** Invalid */
+    SE050_MoreIndicator_NA = 0,
+    /** No more data available */
+    SE050_MoreIndicator_NOT_MORE = 0x01,
+    /** More data available */
+    SE050_MoreIndicator_MORE = 0x02,
+} SE050_MoreIndicator_t;
+
 typedef enum
 { /** Invalid */
     SE050_ECSignatureAlgo_NA = 0,
@@ -115,6 +177,51 @@ typedef enum
     SE050_RSASignatureAlgo_SHA_512_PKCS1 = 0x2A,
 } SE050_RSASignatureAlgo_t;
 
+typedef enum
+{ /** Invalid */
+    SE050_ECCurve_NA = 0,
+    SE050_ECCurve_NIST_P192 = 0x01,
+    SE050_ECCurve_NIST_P224 = 0x02,
+    SE050_ECCurve_NIST_P256 = 0x03,
+    SE050_ECCurve_NIST_P384 = 0x04,
+    SE050_ECCurve_NIST_P521 = 0x05,
+    SE050_ECCurve_Brainpool160 = 0x06,
+    SE050_ECCurve_Brainpool192 = 0x07,
+    SE050_ECCurve_Brainpool224 = 0x08,
+    SE050_ECCurve_Brainpool256 = 0x09,
+    SE050_ECCurve_Brainpool320 = 0x0A,
+    SE050_ECCurve_Brainpool384 = 0x0B,
+    SE050_ECCurve_Brainpool512 = 0x0C,
+    SE050_ECCurve_Secp160k1 = 0x0D,
+    SE050_ECCurve_Secp192k1 = 0x0E,
+    SE050_ECCurve_Secp224k1 = 0x0F,
+    SE050_ECCurve_Secp256k1 = 0x10,
+    SE050_ECCurve_TPM_ECC_BN_P256 = 0x11,
+    SE050_ECCurve_ID_ECC_ED_25519 = 0x40,
+    SE050_ECCurve_ID_ECC_MONT_DH_25519 = 0x41,
+} SE050_ECCurve_t;
+
+typedef enum
+{ /** Invalid */
+    SE050_MACAlgo_NA = 0,
+    SE050_MACAlgo_HMAC_SHA1 = 0x18,
+    SE050_MACAlgo_HMAC_SHA256 = 0x19,
+    SE050_MACAlgo_HMAC_SHA384 = 0x1A,
+    SE050_MACAlgo_HMAC_SHA512 = 0x1B,
+    SE050_MACAlgo_CMAC_128 = 0x31,
+} SE050_MACAlgo_t;
+
+typedef enum
+{ /** Invalid */
+    SE050_CryptoContext_NA = 0,
+    /** For DigestInit/DigestUpdate/DigestFinal */
+    SE050_CryptoContext_DIGEST = 0x01,
+    /** For CipherInit/CipherUpdate/CipherFinal */
+    SE050_CryptoContext_CIPHER = 0x02,
+    /** For MACInit/MACUpdate/MACFinal */
+    SE050_CryptoContext_SIGNATURE = 0x03,
+} SE050_CryptoContext_t;
+
 typedef enum
 {
     SE050_TAG_I2CM_Config = 0x01,
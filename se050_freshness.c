@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_freshness.h"
+#include <string.h>
+
+#define FRESHNESS_MAX_PROBE 32
+
+/*
+ * FNV-1a hash of the 18-byte chip id. 0 is reserved for empty slots.
+ */
+static uint64_t getKey(const uint8_t *chipId) {
+
+	uint64_t h = 0xCBF29CE484222325ULL;
+	for (int k = 0; k < 18; k++) {
+		h ^= chipId[k];
+		h *= 0x100000001B3ULL;
+	}
+	return (h != 0) ? h : 1;
+}
+
+static uint32_t lockSlot(se050_freshnessSlot_t *slot) {
+
+	uint32_t seq;
+
+	/* move the sequence counter from even to odd */
+	do {
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) & ~1U;
+	} while (!__atomic_compare_exchange_n(&slot->seq, &seq, seq + 1, true,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+	return seq;
+}
+
+static void unlockSlot(se050_freshnessSlot_t *slot, uint32_t seq) {
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Find the slot of a chip, claiming an empty one if needed. The slot is
+ * returned locked. Chips with the same fingerprint get different slots,
+ * the chip id being compared under the slot lock.
+ */
+static se050_freshnessSlot_t* findSlot(se050_freshness_t *checker,
+		const uint8_t *chipId, uint32_t *seq) {
+
+	uint64_t key = getKey(chipId);
+	uint32_t idx = (uint32_t) (key ^ (key >> 32)) & checker->mask;
+
+	for (uint32_t n = 0; n < checker->maxProbe; n++) {
+		se050_freshnessSlot_t *slot = &checker->slots[idx];
+		uint64_t current = __atomic_load_n(&slot->key, __ATOMIC_ACQUIRE);
+		if (current == 0) {
+			uint64_t empty = 0;
+			if (__atomic_compare_exchange_n(&slot->key, &empty, key, false,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				current = key;
+			else
+				current = empty;
+		}
+		if (current == key) {
+			*seq = lockSlot(slot);
+			if (!slot->idSet) {
+				memcpy(&slot->chipId[0], chipId, 18);
+				slot->idSet = true;
+				return slot;
+			}
+			if (memcmp(&slot->chipId[0], chipId, 18) == 0)
+				return slot;
+			unlockSlot(slot, *seq);
+		}
+		idx = (idx + 1) & checker->mask;
+	}
+	return NULL;
+}
+
+apdu_status_t se050_freshness_init(se050_freshness_t *checker,
+		se050_freshnessSlot_t *slots, uint32_t nSlots) {
+
+	if (nSlots == 0 || (nSlots & (nSlots - 1)) != 0)
+		return APDU_ERROR;
+	memset(slots, 0, nSlots * sizeof(se050_freshnessSlot_t));
+	checker->slots = slots;
+	checker->mask = nSlots - 1;
+	checker->maxProbe =
+			(nSlots < FRESHNESS_MAX_PROBE) ? nSlots : FRESHNESS_MAX_PROBE;
+	return APDU_OK;
+}
+
+se050_freshnessResult_t se050_freshness_check(se050_freshness_t *checker,
+		const attestation_t *attestation, const uint8_t *challenge) {
+
+	const uint8_t *ts = attestation->timeStamp;
+	uint32_t tsHigh = 0;
+	uint64_t tsLow = 0;
+	uint32_t seq;
+	se050_freshnessSlot_t *slot;
+	se050_freshnessResult_t result;
+
+	if (challenge != NULL
+			&& memcmp(attestation->outrandom, challenge, 16) != 0)
+		return SE050_FRESHNESS_BAD_RANDOM;
+
+	for (int k = 0; k < 4; k++)
+		tsHigh = (tsHigh << 8) | ts[k];
+	for (int k = 4; k < 12; k++)
+		tsLow = (tsLow << 8) | ts[k];
+
+	slot = findSlot(checker, attestation->chipId, &seq);
+	if (slot == NULL)
+		return SE050_FRESHNESS_FULL;
+
+	if (tsHigh > slot->tsHigh
+			|| (tsHigh == slot->tsHigh && tsLow > slot->tsLow)) {
+		slot->tsHigh = tsHigh;
+		slot->tsLow = tsLow;
+		result = SE050_FRESHNESS_OK;
+	} else {
+		result = SE050_FRESHNESS_REPLAY;
+	}
+
+	unlockSlot(slot, seq);
+	return result;
+}
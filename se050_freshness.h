@@ -0,0 +1,110 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_FRESHNESS_H_
+#define SE050_DRV_FRESHNESS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_freshness.h
+ * @author Michael Grand
+ *
+ * Replay and freshness checks of attestations, to be used after signature
+ * verification. An attestation is fresh if it echoes the challenge sent
+ * with the command and if its 12-byte time stamp is greater than the last one
+ * accepted for the same chip.
+ *
+ * Last time stamps are kept in a caller-provided open addressing table
+ * indexed by a 64-bit fingerprint of the chip id (48 bytes per chip). Each
+ * slot also keeps the full chip id, so chips with the same fingerprint use
+ * different slots. The table never grows: chips which do not fit are reported
+ * as SE050_FRESHNESS_FULL. Slots are claimed with compare-and-swap and each
+ * slot is updated under its own spin lock, so the table needs no global lock
+ * and checks of different chips never wait for each other, while concurrent
+ * checks of the same chip wait for each other.
+ */
+
+/**
+ * Result of a freshness check.
+ */
+typedef enum {
+	SE050_FRESHNESS_OK,			///< Attestation is fresh, its time stamp has been recorded
+	SE050_FRESHNESS_REPLAY,		///< Time stamp is not greater than the last accepted one
+	SE050_FRESHNESS_BAD_RANDOM,	///< Random does not match the challenge
+	SE050_FRESHNESS_FULL		///< Chip is unknown and the table is full
+} se050_freshnessResult_t;
+
+/**
+ * Per-chip state.
+ */
+typedef struct {
+	/// Fingerprint of the chip id, 0 for an empty slot
+	uint64_t key;
+	/// Spin lock sequence counter, odd while the slot is locked
+	uint32_t seq;
+	/// 4 most significant bytes of the last time stamp
+	uint32_t tsHigh;
+	/// 8 least significant bytes of the last time stamp
+	uint64_t tsLow;
+	/// Chip id, set by the first check of the chip
+	uint8_t chipId[18];
+	/// True once chipId is set
+	bool idSet;
+} se050_freshnessSlot_t;
+
+/**
+ * Freshness checker.
+ */
+typedef struct {
+	/// Slot table
+	se050_freshnessSlot_t *slots;
+	/// Number of slots minus one
+	uint32_t mask;
+	/// Maximum number of slots probed for a chip
+	uint32_t maxProbe;
+} se050_freshness_t;
+
+/**
+ * Initialize a freshness checker.
+ * @param checker Pointer to a checker structure
+ * @param slots Slot table, its content is cleared
+ * @param nSlots Number of slots, must be a power of two
+ * @returns APDU_ERROR if nSlots is not a power of two
+ */
+apdu_status_t se050_freshness_init(se050_freshness_t *checker,
+		se050_freshnessSlot_t *slots, uint32_t nSlots);
+
+/**
+ * Check an attestation and record its time stamp if it is fresh.
+ * This function may be called concurrently from several threads.
+ * @param checker Pointer to an initialized checker structure
+ * @param attestation Pointer to an attestation with a valid signature
+ * @param challenge Pointer to the 16-byte random sent with the command, NULL to skip this check
+ * @returns result of the check
+ */
+se050_freshnessResult_t se050_freshness_check(se050_freshness_t *checker,
+		const attestation_t *attestation, const uint8_t *challenge);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_FRESHNESS_H_ */
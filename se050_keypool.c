@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_keypool.h"
+#include <string.h>
+
+static apdu_status_t generate(se050_keypool_t *pool, se050_keypoolSlot_t *slot,
+		apdu_ctx_t *ctx) {
+
+	if (slot->created) {
+		if (se050_generateECKey(slot->objId, SE050_ECCurve_NA, true, ctx)
+				== APDU_OK)
+			return APDU_OK;
+		/* object may have been lost, e.g. on a SE050 reset */
+		slot->created = false;
+	}
+	if (se050_generateECKey(slot->objId, pool->curve, true, ctx) != APDU_OK) {
+		/* the SE050 keeps transient objects across a power cycle and only
+		 * clears their values, so the object may exist after a reset */
+		bool exists = false;
+		if (se050_checkObjectExists(slot->objId, &exists, ctx) != APDU_OK
+				|| !exists
+				|| se050_generateECKey(slot->objId, SE050_ECCurve_NA, true,
+						ctx) != APDU_OK)
+			return APDU_ERROR;
+	}
+	slot->created = true;
+	return APDU_OK;
+}
+
+void se050_keypool_init(se050_keypool_t *pool, uint32_t baseId, uint8_t nSlots,
+		SE050_ECCurve_t curve) {
+
+	memset(pool, 0, sizeof(se050_keypool_t));
+	if (nSlots > MBED_CONF_SE050_KEYPOOL_SIZE)
+		nSlots = MBED_CONF_SE050_KEYPOOL_SIZE;
+	pool->nSlots = nSlots;
+	pool->curve = curve;
+	for (uint8_t k = 0; k < nSlots; k++)
+		pool->slots[k].objId = baseId + k;
+	se050_keypool_reset(pool);
+}
+
+void se050_keypool_reset(se050_keypool_t *pool) {
+
+	for (uint8_t k = 0; k < pool->nSlots; k++) {
+		pool->slots[k].state = SE050_KEYPOOL_EMPTY;
+		pool->slots[k].created = false;
+	}
+}
+
+apdu_status_t se050_keypool_idle(se050_keypool_t *pool, apdu_ctx_t *ctx) {
+
+	for (uint8_t k = 0; k < pool->nSlots; k++) {
+		se050_keypoolSlot_t *slot = &pool->slots[k];
+		if (slot->state == SE050_KEYPOOL_EMPTY) {
+			if (generate(pool, slot, ctx) != APDU_OK)
+				return APDU_ERROR;
+			slot->state = SE050_KEYPOOL_READY;
+			return APDU_OK;
+		}
+	}
+	return APDU_OK;
+}
+
+bool se050_keypool_needsRefill(const se050_keypool_t *pool) {
+
+	for (uint8_t k = 0; k < pool->nSlots; k++) {
+		if (pool->slots[k].state == SE050_KEYPOOL_EMPTY)
+			return true;
+	}
+	return false;
+}
+
+apdu_status_t se050_keypool_take(se050_keypool_t *pool, uint32_t *objId,
+		apdu_ctx_t *ctx) {
+
+	se050_keypoolSlot_t *empty = NULL;
+
+	for (uint8_t k = 0; k < pool->nSlots; k++) {
+		se050_keypoolSlot_t *slot = &pool->slots[k];
+		if (slot->state == SE050_KEYPOOL_READY) {
+			slot->state = SE050_KEYPOOL_IN_USE;
+			*objId = slot->objId;
+			pool->hits++;
+			return APDU_OK;
+		}
+		if (slot->state == SE050_KEYPOOL_EMPTY && empty == NULL)
+			empty = slot;
+	}
+
+	if (empty == NULL)
+		return APDU_ERROR;
+	pool->misses++;
+	if (generate(pool, empty, ctx) != APDU_OK)
+		return APDU_ERROR;
+	empty->state = SE050_KEYPOOL_IN_USE;
+	*objId = empty->objId;
+	return APDU_OK;
+}
+
+void se050_keypool_release(se050_keypool_t *pool, uint32_t objId) {
+
+	for (uint8_t k = 0; k < pool->nSlots; k++) {
+		if (pool->slots[k].objId == objId
+				&& pool->slots[k].state == SE050_KEYPOOL_IN_USE)
+			pool->slots[k].state = SE050_KEYPOOL_EMPTY;
+	}
+}
@@ -0,0 +1,140 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_KEYPOOL_H_
+#define SE050_DRV_KEYPOOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_keypool.h
+ * @author Michael Grand
+ *
+ * Pool of transient EC key pair objects generated ahead of time. The
+ * application calls se050_keypool_idle() when the SE050 is not used (e.g.
+ * from its idle loop or a low priority event), or lets the worker thread do it
+ * whenever its queues are empty (see se050_worker_setKeypool()), so that
+ * se050_keypool_take() can return a fresh key pair without waiting for its
+ * generation.
+ *
+ * Transient key values are cleared when the SE050 is reset or powered off,
+ * while the transient objects themselves remain: se050_keypool_reset() must be
+ * called after each se050_connect(). The worker thread does it for its pool
+ * after each wakeup of its power manager. Key pairs are then generated again
+ * in the existing objects.
+ */
+
+#ifndef MBED_CONF_SE050_KEYPOOL_SIZE
+#define MBED_CONF_SE050_KEYPOOL_SIZE 2
+#endif
+
+/**
+ * State of a key pool slot.
+ */
+typedef enum {
+	SE050_KEYPOOL_EMPTY,	///< A new key pair has to be generated
+	SE050_KEYPOOL_READY,	///< A fresh key pair is available
+	SE050_KEYPOOL_IN_USE	///< Key pair is used by the application
+} se050_keypoolState_t;
+
+/**
+ * Key pool slot.
+ */
+typedef struct {
+	/// Identifier of the transient key pair object
+	uint32_t objId;
+	/// State of the slot
+	se050_keypoolState_t state;
+	/// True once the transient object has been created in the SE050
+	bool created;
+} se050_keypoolSlot_t;
+
+/**
+ * Pool of pre-generated EC key pairs.
+ */
+typedef struct se050_keypool {
+	/// Key pool slots
+	se050_keypoolSlot_t slots[MBED_CONF_SE050_KEYPOOL_SIZE];
+	/// Number of slots in use
+	uint8_t nSlots;
+	/// Curve of the generated key pairs
+	SE050_ECCurve_t curve;
+	/// Number of key pairs taken from the pool without waiting
+	uint32_t hits;
+	/// Number of key pairs which had to be generated on demand
+	uint32_t misses;
+} se050_keypool_t;
+
+/**
+ * Initialize a key pool. Slots use the object identifiers baseId to baseId + nSlots - 1.
+ * @param pool Pointer to a key pool structure
+ * @param baseId Identifier of the first key pair object
+ * @param nSlots Number of slots (at most MBED_CONF_SE050_KEYPOOL_SIZE)
+ * @param curve Curve of the generated key pairs
+ */
+void se050_keypool_init(se050_keypool_t *pool, uint32_t baseId, uint8_t nSlots,
+		SE050_ECCurve_t curve);
+
+/**
+ * Mark all slots as empty, e.g. after a reset of the SE050. Slots are
+ * also marked as not created, se050_keypool_idle() and se050_keypool_take()
+ * reuse their objects if they still exist.
+ * @param pool Pointer to an initialized key pool structure
+ */
+void se050_keypool_reset(se050_keypool_t *pool);
+
+/**
+ * Generate a key pair for the first empty slot, if any.
+ * @param pool Pointer to an initialized key pool structure
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns APDU_OK if a key pair was generated or if the pool is already full
+ */
+apdu_status_t se050_keypool_idle(se050_keypool_t *pool, apdu_ctx_t *ctx);
+
+/**
+ * Check if a slot is waiting for a key pair.
+ * @param pool Pointer to an initialized key pool structure
+ * @returns true if se050_keypool_idle() has a key pair to generate
+ */
+bool se050_keypool_needsRefill(const se050_keypool_t *pool);
+
+/**
+ * Get a fresh key pair. If no key pair is ready, one is generated on demand.
+ * @param pool Pointer to an initialized key pool structure
+ * @param objId Pointer to the identifier of the key pair object
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if a key pair is available
+ */
+apdu_status_t se050_keypool_take(se050_keypool_t *pool, uint32_t *objId,
+		apdu_ctx_t *ctx);
+
+/**
+ * Give back a key pair once it is not needed anymore. A new key pair will be
+ * generated in its slot by se050_keypool_idle().
+ * @param pool Pointer to an initialized key pool structure
+ * @param objId Identifier of the key pair object
+ */
+void se050_keypool_release(se050_keypool_t *pool, uint32_t objId);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_KEYPOOL_H_ */
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_pkcache.h"
+#include <string.h>
+
+static void flush(se050_pkcache_t *cache, uint32_t generation) {
+	cache->count = 0;
+	cache->used = 0;
+	cache->generation = generation;
+}
+
+static void evict(se050_pkcache_t *cache, uint8_t k) {
+
+	se050_pkcacheEntry_t *entry = &cache->entries[k];
+	uint16_t end = entry->offset + entry->len;
+	uint16_t len = entry->len;
+
+	memmove(&cache->pool[entry->offset], &cache->pool[end], cache->used - end);
+	cache->used -= len;
+	for (uint8_t i = k + 1; i < cache->count; i++) {
+		cache->entries[i - 1] = cache->entries[i];
+		cache->entries[i - 1].offset -= len;
+	}
+	cache->count--;
+}
+
+static void evictLRU(se050_pkcache_t *cache) {
+
+	uint8_t lru = 0;
+	for (uint8_t k = 1; k < cache->count; k++) {
+		if (cache->entries[k].lastUse < cache->entries[lru].lastUse)
+			lru = k;
+	}
+	evict(cache, lru);
+}
+
+static uint8_t findEntry(se050_pkcache_t *cache, uint32_t objId) {
+
+	uint8_t k = 0;
+	while (k < cache->count && cache->entries[k].id != objId)
+		k++;
+	return k;
+}
+
+/*
+ * Evict the objects changed by this driver since the last lookup. The whole
+ * cache is flushed if one of the changes is unknown or no longer journaled.
+ */
+static void checkUpToDate(se050_pkcache_t *cache, apdu_ctx_t *ctx) {
+
+	se050_objChange_t change;
+	uint8_t k;
+
+	while (cache->generation != ctx->objGeneration) {
+		if (!se050_getObjChange(cache->generation + 1, &change, ctx)
+				|| change.kind == SE050_OBJ_UNKNOWN) {
+			flush(cache, ctx->objGeneration);
+			return;
+		}
+		k = findEntry(cache, change.objId);
+		if (k < cache->count)
+			evict(cache, k);
+		cache->generation++;
+	}
+}
+
+static apdu_status_t copyChunk(const uint8_t *buff, uint32_t len,
+		uint32_t offset, void *arg) {
+	memcpy((uint8_t*) arg + offset, buff, len);
+	return APDU_OK;
+}
+
+/*
+ * Read an object at the end of the pool, evicting entries as needed.
+ * Binary objects are read chunk by chunk, other objects (keys) with
+ * a single ReadObject.
+ */
+static apdu_status_t load(se050_pkcache_t *cache, uint32_t objId,
+		apdu_ctx_t *ctx) {
+
+	se050_pkcacheEntry_t *entry;
+	phNxpEse_data data;
+	apdu_status_t status;
+	uint8_t type;
+	uint16_t size;
+
+	if (se050_readType(objId, &type, ctx) != APDU_OK)
+		return APDU_ERROR;
+
+	if (type == SE050_SecureObjectType_BINARY_FILE) {
+		if (se050_readSize(objId, &size, ctx) != APDU_OK
+				|| size > MBED_CONF_SE050_PKCACHE_SIZE)
+			return APDU_ERROR;
+		while (cache->count == MBED_CONF_SE050_PKCACHE_ENTRIES
+				|| cache->used + size > MBED_CONF_SE050_PKCACHE_SIZE)
+			evictLRU(cache);
+		/* the stream yields between chunks: a nested lookup must not
+		 * reuse the end of the pool */
+		cache->loading = true;
+		status = se050_readObjectStream(objId, size, copyChunk,
+				&cache->pool[cache->used], ctx);
+		cache->loading = false;
+		if (status != APDU_OK)
+			return APDU_ERROR;
+	} else {
+		if (se050_readObject(objId, 0, 0, &data, ctx) != APDU_OK
+				|| data.len > MBED_CONF_SE050_PKCACHE_SIZE)
+			return APDU_ERROR;
+		size = data.len;
+		while (cache->count == MBED_CONF_SE050_PKCACHE_ENTRIES
+				|| cache->used + size > MBED_CONF_SE050_PKCACHE_SIZE)
+			evictLRU(cache);
+		memcpy(&cache->pool[cache->used], data.p_data, size);
+	}
+
+	entry = &cache->entries[cache->count++];
+	entry->id = objId;
+	entry->offset = cache->used;
+	entry->len = size;
+	entry->lastUse = ++cache->useCounter;
+	cache->used += size;
+	return APDU_OK;
+}
+
+void se050_pkcache_init(se050_pkcache_t *cache) {
+	memset(cache, 0, sizeof(se050_pkcache_t));
+}
+
+apdu_status_t se050_pkcache_get(se050_pkcache_t *cache, uint32_t objId,
+		phNxpEse_data *value, apdu_ctx_t *ctx) {
+
+	se050_pkcacheEntry_t *entry = NULL;
+	uint8_t k;
+
+	checkUpToDate(cache, ctx);
+	k = findEntry(cache, objId);
+	if (k < cache->count)
+		entry = &cache->entries[k];
+
+	if (entry == NULL && cache->loading)
+		return APDU_ERROR;
+	if (entry != NULL) {
+		cache->hits++;
+		cache->bytesSaved += entry->len;
+		entry->lastUse = ++cache->useCounter;
+	} else {
+		cache->misses++;
+		if (load(cache, objId, ctx) != APDU_OK)
+			return APDU_ERROR;
+		entry = &cache->entries[cache->count - 1];
+	}
+	value->p_data = &cache->pool[entry->offset];
+	value->len = entry->len;
+	return APDU_OK;
+}
+
+apdu_status_t se050_pkcache_warmup(se050_pkcache_t *cache,
+		const uint32_t *ids, uint8_t nIds, apdu_ctx_t *ctx) {
+
+	phNxpEse_data value;
+	apdu_status_t status = APDU_OK;
+
+	for (uint8_t k = 0; k < nIds; k++) {
+		if (se050_pkcache_get(cache, ids[k], &value, ctx) != APDU_OK)
+			status = APDU_ERROR;
+	}
+	return status;
+}
+
+static void sessionWarmup(apdu_ctx_t *ctx, void *arg) {
+
+	se050_pkcache_t *cache = arg;
+
+	if (cache->prevSessionHook != NULL)
+		cache->prevSessionHook(ctx, cache->prevSessionArg);
+	se050_pkcache_warmup(cache, cache->warmupIds, cache->nWarmupIds, ctx);
+}
+
+void se050_pkcache_warmupOnSession(se050_pkcache_t *cache,
+		const uint32_t *ids, uint8_t nIds) {
+
+	se050_sessionHook_t hook;
+	void *arg;
+	bool installed;
+
+	se050_getSessionHook(&hook, &arg);
+	installed = (hook == sessionWarmup && arg == cache);
+	cache->warmupIds = ids;
+	cache->nWarmupIds = nIds;
+	if (nIds > 0 && !installed) {
+		cache->prevSessionHook = hook;
+		cache->prevSessionArg = arg;
+		se050_setSessionHook(sessionWarmup, cache);
+	} else if (nIds == 0 && installed) {
+		se050_setSessionHook(cache->prevSessionHook, cache->prevSessionArg);
+		cache->prevSessionHook = NULL;
+		cache->prevSessionArg = NULL;
+	}
+}
@@ -0,0 +1,149 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_PKCACHE_H_
+#define SE050_DRV_PKCACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_pkcache.h
+ * @author Michael Grand
+ *
+ * Bounded cache of public keys and certificates read from the SE050. Cached
+ * values are stored in a fixed-size pool and evicted in least recently used
+ * order. Objects changed by this driver are evicted using the object change
+ * journal of the APDU context (see se050_getObjChange()); the whole cache is
+ * flushed after se050_connect(), after a lost response or when more changes
+ * than the journal holds happened since the last lookup.
+ */
+
+#ifndef MBED_CONF_SE050_PKCACHE_SIZE
+#define MBED_CONF_SE050_PKCACHE_SIZE 1024
+#endif
+
+#if MBED_CONF_SE050_PKCACHE_SIZE > 65535
+#error "se050.pkcache-size must fit the 16-bit offsets of the cache entries"
+#endif
+
+#ifndef MBED_CONF_SE050_PKCACHE_ENTRIES
+#define MBED_CONF_SE050_PKCACHE_ENTRIES 4
+#endif
+
+/**
+ * Cached object descriptor.
+ */
+typedef struct {
+	/// Object identifier
+	uint32_t id;
+	/// Offset of the object value in the pool
+	uint16_t offset;
+	/// Length of the object value
+	uint16_t len;
+	/// Value of the use counter when the entry was last used
+	uint32_t lastUse;
+} se050_pkcacheEntry_t;
+
+/**
+ * Public key and certificate cache.
+ */
+typedef struct {
+	/// Storage of cached values
+	uint8_t pool[MBED_CONF_SE050_PKCACHE_SIZE];
+	/// Cached objects, in pool order
+	se050_pkcacheEntry_t entries[MBED_CONF_SE050_PKCACHE_ENTRIES];
+	/// Number of cached objects
+	uint8_t count;
+	/// Number of pool bytes in use
+	uint16_t used;
+	/// Counter used to track least recently used entries
+	uint32_t useCounter;
+	/// Value of apdu_ctx_t.objGeneration the cached values are up to date with
+	uint32_t generation;
+	/// Objects loaded at the start of each session, see se050_pkcache_warmupOnSession()
+	const uint32_t *warmupIds;
+	/// Number of objects loaded at the start of each session
+	uint8_t nWarmupIds;
+	/// Session hook called before the warm-up, see se050_getSessionHook()
+	se050_sessionHook_t prevSessionHook;
+	/// Argument of the chained session hook
+	void *prevSessionArg;
+	/// Set while an object is read into the pool
+	bool loading;
+	/// Number of lookups served from the cache
+	uint32_t hits;
+	/// Number of lookups which required reading the SE050
+	uint32_t misses;
+	/// Number of object bytes which did not have to be read from the SE050
+	uint32_t bytesSaved;
+} se050_pkcache_t;
+
+/**
+ * Initialize an empty cache and reset its counters.
+ * @param cache Pointer to a cache structure
+ */
+void se050_pkcache_init(se050_pkcache_t *cache);
+
+/**
+ * Get the value of a public key or certificate object. On a miss, the object
+ * is read from the SE050 (binary objects are read chunk by chunk) and stored
+ * in the cache.
+ * @param cache Pointer to an initialized cache structure
+ * @param objId Identifier of the object
+ * @param value Structure receiving a pointer to the cached value and its length.
+ * The pointer remains valid until the next call to a se050_pkcache function.
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if the value is available (APDU_ERROR if it exceeds MBED_CONF_SE050_PKCACHE_SIZE,
+ * or if called from a yield hook while the same cache reads an object)
+ */
+apdu_status_t se050_pkcache_get(se050_pkcache_t *cache, uint32_t objId,
+		phNxpEse_data *value, apdu_ctx_t *ctx);
+
+/**
+ * Load a set of objects in the cache, typically right after se050_connect()
+ * and se050_select().
+ * @param cache Pointer to an initialized cache structure
+ * @param ids Pointer to an array of object identifiers
+ * @param nIds Number of identifiers
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if all objects have been loaded
+ */
+apdu_status_t se050_pkcache_warmup(se050_pkcache_t *cache,
+		const uint32_t *ids, uint8_t nIds, apdu_ctx_t *ctx);
+
+/**
+ * Load a set of objects in the cache each time a session is established,
+ * i.e. after each successful se050_select() including the ones of the power
+ * manager on wakeup. This installs a session hook (see
+ * se050_setSessionHook()) which first calls the hook set before it, so hooks
+ * set before this call keep being called. Stopping the warm-up restores that
+ * hook if no other hook was set in the meantime.
+ * @param cache Pointer to an initialized cache structure
+ * @param ids Pointer to an array of object identifiers, which must remain valid
+ * @param nIds Number of identifiers, 0 to stop loading objects on session start
+ */
+void se050_pkcache_warmupOnSession(se050_pkcache_t *cache,
+		const uint32_t *ids, uint8_t nIds);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_PKCACHE_H_ */
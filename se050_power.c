@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_power.h"
+#include "se050_powerlog.h"
+#include "platform/reset.h"
+#include "platform/timer.h"
+#include <string.h>
+
+/*
+ * Accumulate on-time. Called often enough for the 32-bit microsecond counter
+ * not to wrap around between two calls.
+ */
+static void account(se050_power_t *pm, uint32_t now) {
+	if (pm->on)
+		pm->onTime += now - pm->mark;
+	pm->mark = now;
+}
+
+void se050_power_init(se050_power_t *pm, uint32_t timeout,
+		se050_wakeupHook_t wakeup, void *arg, apdu_ctx_t *ctx) {
+
+	memset(pm, 0, sizeof(se050_power_t));
+	pm->ctx = ctx;
+	pm->timeout = timeout * 1000;
+	pm->wakeup = wakeup;
+	pm->arg = arg;
+	pm->on = true;
+	pm->last = se050_timer_us();
+	pm->mark = pm->last;
+}
+
+apdu_status_t se050_power_acquire(se050_power_t *pm) {
+	apdu_status_t status;
+	uint32_t start;
+
+	if (!pm->on) {
+		start = se050_timer_us();
+		account(pm, start);
+		se050_powerOn();
+		se050_powerlog_state(SE050_PWR_IDLE);
+		pm->on = true;
+		/* only transient objects changed while the SE050 was off */
+		status = se050_reconnect(pm->ctx);
+		if (status == APDU_OK)
+			status = se050_select(pm->ctx);
+		if (status != APDU_OK) {
+			se050_disconnect(pm->ctx);
+			se050_powerOff();
+			se050_powerlog_state(SE050_PWR_OFF);
+			account(pm, se050_timer_us());
+			pm->on = false;
+			pm->wakeupFailures++;
+			return APDU_ERROR;
+		}
+		pm->wakeupTime += se050_timer_us() - start;
+		pm->wakeups++;
+		if (pm->wakeup != NULL)
+			pm->wakeup(pm->ctx, pm->arg);
+	}
+	pm->users++;
+	return APDU_OK;
+}
+
+void se050_power_release(se050_power_t *pm) {
+	if (pm->users > 0)
+		pm->users--;
+	pm->last = se050_timer_us();
+}
+
+uint32_t se050_power_idle(se050_power_t *pm) {
+	uint32_t now = se050_timer_us();
+	uint32_t idle = now - pm->last;
+
+	account(pm, now);
+	if (!pm->on || pm->users > 0)
+		return 0;
+	if (idle < pm->timeout)
+		return (pm->timeout - idle + 999) / 1000;
+
+	se050_disconnect(pm->ctx);
+	se050_powerOff();
+	se050_powerlog_state(SE050_PWR_OFF);
+	pm->on = false;
+	pm->powerDowns++;
+	return 0;
+}
+
+uint64_t se050_power_onTime(se050_power_t *pm) {
+	account(pm, se050_timer_us());
+	return pm->onTime;
+}
@@ -0,0 +1,144 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_POWER_H_
+#define SE050_DRV_POWER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_power.h
+ * @author Michael Grand
+ *
+ * Idle power manager. Commands are bracketed by se050_power_acquire() and
+ * se050_power_release(), and se050_power_idle() is called periodically. The
+ * SE050 is switched off through its ENA pin once no command has been sent for
+ * the idle timeout, and switched on again, reconnected (see se050_reconnect())
+ * and reselected by the next se050_power_acquire().
+ *
+ * Power cycles clear sessions and the values of transient objects, while the
+ * transient objects themselves remain: the wakeup hook is the place to call
+ * e.g. se050_keypool_reset() (the worker thread does it for the key pool set
+ * with se050_worker_setKeypool()). The reconnection journals the transient
+ * objects as modified, so that the se050_dir and se050_pkcache caches only
+ * drop those.
+ *
+ * Example:
+ * @code
+ *	se050_power_init(&pm, MBED_CONF_SE050_POWER_IDLE_TIMEOUT, NULL, NULL, &ctx);
+ *	...
+ *	if (se050_power_acquire(&pm) == APDU_OK) {
+ *		status = se050_getRandom(random, 16, &ctx);
+ *		se050_power_release(&pm);
+ *	}
+ *	...
+ *	se050_power_idle(&pm); // from the application idle loop
+ * @endcode
+ */
+
+#ifndef MBED_CONF_SE050_POWER_IDLE_TIMEOUT
+#define MBED_CONF_SE050_POWER_IDLE_TIMEOUT 500
+#endif
+
+/**
+ * Hook called once the session has been restored after a power down.
+ */
+typedef void (*se050_wakeupHook_t)(apdu_ctx_t *ctx, void *arg);
+
+/**
+ * Idle power manager.
+ */
+typedef struct se050_power {
+	/// Context of the managed session
+	apdu_ctx_t *ctx;
+	/// Idle timeout in microseconds
+	uint32_t timeout;
+	/// Wakeup hook, may be NULL
+	se050_wakeupHook_t wakeup;
+	/// Argument of the wakeup hook
+	void *arg;
+	/// True while the SE050 is powered
+	bool on;
+	/// Number of pending se050_power_acquire() calls
+	uint32_t users;
+	/// Time of the last se050_power_release()
+	uint32_t last;
+	/// Time on-time was last accumulated
+	uint32_t mark;
+	/// Time the SE050 has been powered, in microseconds
+	uint64_t onTime;
+	/// Time spent restoring sessions, in microseconds
+	uint64_t wakeupTime;
+	/// Number of restored sessions
+	uint32_t wakeups;
+	/// Number of failed session restorations
+	uint32_t wakeupFailures;
+	/// Number of power downs
+	uint32_t powerDowns;
+} se050_power_t;
+
+/**
+ * Initialize a power manager. The SE050 must be powered, connected and
+ * selected.
+ * @param pm Pointer to a power manager
+ * @param timeout Idle timeout in milliseconds
+ * @param wakeup Hook called after each session restoration, may be NULL
+ * @param arg Argument of the wakeup hook
+ * @param ctx Pointer to an initialized APDU context structure
+ */
+void se050_power_init(se050_power_t *pm, uint32_t timeout,
+		se050_wakeupHook_t wakeup, void *arg, apdu_ctx_t *ctx);
+
+/**
+ * Make sure the SE050 is powered and selected before sending commands. Calls
+ * may be nested.
+ * @param pm Pointer to an initialized power manager
+ * @returns APDU_ERROR if the session cannot be restored, the SE050 is then left off
+ */
+apdu_status_t se050_power_acquire(se050_power_t *pm);
+
+/**
+ * End of the commands started by se050_power_acquire(). The idle timeout
+ * starts when the last pending acquisition is released.
+ * @param pm Pointer to an initialized power manager
+ */
+void se050_power_release(se050_power_t *pm);
+
+/**
+ * Switch the SE050 off if it has been idle for the timeout.
+ * @param pm Pointer to an initialized power manager
+ * @returns Number of milliseconds before the SE050 will be switched off,
+ * 0 if it is off or in use
+ */
+uint32_t se050_power_idle(se050_power_t *pm);
+
+/**
+ * Get the time the SE050 has been powered since se050_power_init().
+ * @param pm Pointer to an initialized power manager
+ * @returns On-time in microseconds
+ */
+uint64_t se050_power_onTime(se050_power_t *pm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SE050_DRV_POWER_H_ */
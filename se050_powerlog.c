@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_powerlog.h"
+#include "platform/timer.h"
+#include <string.h>
+
+static se050_powerLog_t *attached = NULL;
+
+static void account(se050_powerLog_t *log, uint32_t now) {
+	log->time[log->state] += now - log->mark;
+	log->mark = now;
+}
+
+static void recordLatency(se050_latencyStats_t *stats, uint32_t latency) {
+	stats->count++;
+	stats->sum += latency;
+	if (latency > stats->max)
+		stats->max = latency;
+}
+
+void se050_powerlog_init(se050_powerLog_t *log, se050_pwrState_t state) {
+	memset(log, 0, sizeof(se050_powerLog_t));
+	log->current[SE050_PWR_OFF] = 0;
+	log->current[SE050_PWR_LOW] = MBED_CONF_SE050_CURRENT_LOW_UA;
+	log->current[SE050_PWR_IDLE] = MBED_CONF_SE050_CURRENT_IDLE_UA;
+	log->current[SE050_PWR_ACTIVE] = MBED_CONF_SE050_CURRENT_ACTIVE_UA;
+	log->state = state;
+	log->resumed = state;
+	log->mark = se050_timer_us();
+}
+
+void se050_powerlog_attach(se050_powerLog_t *log) {
+	attached = log;
+}
+
+void se050_powerlog_state(se050_pwrState_t state) {
+	se050_powerLog_t *log = attached;
+	uint32_t now;
+
+	if (log == NULL || state == log->state)
+		return;
+
+	now = se050_timer_us();
+	if (log->state == SE050_PWR_ACTIVE)
+		recordLatency((log->resumed == SE050_PWR_LOW) ? &log->wakeup : &log->awake,
+				now - log->mark);
+	if (state == SE050_PWR_ACTIVE)
+		log->resumed = log->state;
+	account(log, now);
+	log->state = state;
+}
+
+uint32_t se050_powerlog_averageCurrent(se050_powerLog_t *log) {
+	uint64_t charge = 0;
+	uint64_t total = 0;
+
+	account(log, se050_timer_us());
+	for (int k = 0; k < SE050_PWR_STATES; k++) {
+		charge += log->time[k] * log->current[k];
+		total += log->time[k];
+	}
+	return (total != 0) ? (uint32_t) (charge / total) : 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_POWERLOG_H_
+#define SE050_DRV_POWERLOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @file se050_powerlog.h
+ * @author Michael Grand
+ *
+ * Power profile logger. The driver reports the power state of the SE050
+ * (off, low power after an end of session, idle, processing an APDU), the
+ * logger accumulates the time spent in each state and estimates the average
+ * supply current from a per-state current table. APDU latencies are recorded
+ * separately depending on whether the APDU woke the SE050 from low power, so
+ * that the cost of end of session policies (see se050_setEosPolicy()) can be
+ * weighed against the current they save.
+ *
+ * Default currents are rough estimates and should be calibrated on the board.
+ */
+
+#ifndef MBED_CONF_SE050_CURRENT_ACTIVE_UA
+#define MBED_CONF_SE050_CURRENT_ACTIVE_UA 10000
+#endif
+
+#ifndef MBED_CONF_SE050_CURRENT_IDLE_UA
+#define MBED_CONF_SE050_CURRENT_IDLE_UA 400
+#endif
+
+#ifndef MBED_CONF_SE050_CURRENT_LOW_UA
+#define MBED_CONF_SE050_CURRENT_LOW_UA 5
+#endif
+
+/**
+ * Power state of the SE050.
+ */
+typedef enum {
+	SE050_PWR_OFF = 0,	///< Supply switched off
+	SE050_PWR_LOW,		///< Low power mode after an end of session
+	SE050_PWR_IDLE,		///< Awake, no APDU in progress
+	SE050_PWR_ACTIVE,	///< Processing an APDU
+	SE050_PWR_STATES
+} se050_pwrState_t;
+
+/**
+ * APDU latency statistics.
+ */
+typedef struct {
+	/// Number of APDUs
+	uint32_t count;
+	/// Sum of latencies in microseconds
+	uint64_t sum;
+	/// Maximum latency in microseconds
+	uint32_t max;
+} se050_latencyStats_t;
+
+/**
+ * Power profile logger.
+ */
+typedef struct {
+	/// Estimated current of each state in microamperes
+	uint32_t current[SE050_PWR_STATES];
+	/// Time spent in each state in microseconds
+	uint64_t time[SE050_PWR_STATES];
+	/// Current state
+	se050_pwrState_t state;
+	/// State left when the current APDU started
+	se050_pwrState_t resumed;
+	/// Time the current state was entered
+	uint32_t mark;
+	/// Latencies of APDUs sent while the SE050 was awake
+	se050_latencyStats_t awake;
+	/// Latencies of APDUs waking the SE050 from low power
+	se050_latencyStats_t wakeup;
+} se050_powerLog_t;
+
+/**
+ * Initialize a logger with the configured currents.
+ * @param log Pointer to a logger
+ * @param state Current power state of the SE050
+ */
+void se050_powerlog_init(se050_powerLog_t *log, se050_pwrState_t state);
+
+/**
+ * Make log the logger receiving state changes reported by the driver.
+ * @param log Pointer to an initialized logger, NULL to stop logging
+ */
+void se050_powerlog_attach(se050_powerLog_t *log);
+
+/**
+ * Report a power state change to the attached logger, if any.
+ * @param state New power state
+ */
+void se050_powerlog_state(se050_pwrState_t state);
+
+/**
+ * Get the average current since the logger initialization.
+ * @param log Pointer to an initialized logger
+ * @returns Estimated average current in microamperes
+ */
+uint32_t se050_powerlog_averageCurrent(se050_powerLog_t *log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SE050_DRV_POWERLOG_H_ */
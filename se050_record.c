@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_record.h"
+#include "se050_tlv.h"
+#include <string.h>
+
+/*
+ * Length of the record body: the signed message and the signature TLV which
+ * directly follows it in the response buffer.
+ */
+static uint32_t getBodyLen(const attestation_t *attestation) {
+
+	const uint8_t *end;
+
+	if (attestation->message.p_data == NULL
+			|| attestation->signature.p_data == NULL)
+		return 0;
+	end = attestation->signature.p_data + attestation->signature.len;
+	if (end <= attestation->message.p_data + attestation->message.len)
+		return 0;
+	return end - attestation->message.p_data;
+}
+
+static void setHeader(uint8_t *header, SE050_AttestationAlgo_t algo,
+		uint32_t bodyLen) {
+	header[0] = SE050_RECORD_VERSION;
+	header[1] = algo;
+	header[2] = (bodyLen & 0xFF00) >> 8;
+	header[3] = bodyLen & 0x00FF;
+}
+
+uint32_t se050_record_size(const attestation_t *attestation) {
+
+	uint32_t bodyLen = getBodyLen(attestation);
+	if (bodyLen == 0 || bodyLen > 0xFFFF)
+		return 0;
+	return SE050_RECORD_HEADER_LEN + bodyLen;
+}
+
+apdu_status_t se050_record_serialize(const attestation_t *attestation,
+		SE050_AttestationAlgo_t algo, uint8_t *buff, uint32_t *len) {
+
+	uint32_t size = se050_record_size(attestation);
+
+	if (size == 0 || size > *len)
+		return APDU_ERROR;
+	setHeader(&buff[0], algo, size - SE050_RECORD_HEADER_LEN);
+	memcpy(&buff[SE050_RECORD_HEADER_LEN], attestation->message.p_data,
+			size - SE050_RECORD_HEADER_LEN);
+	*len = size;
+	return APDU_OK;
+}
+
+apdu_status_t se050_record_read(const uint8_t *record, uint32_t len,
+		SE050_AttestationAlgo_t *algo, attestation_t *attestation,
+		uint32_t *recordLen) {
+
+	uint32_t bodyLen;
+	const uint8_t *body = &record[SE050_RECORD_HEADER_LEN];
+	se050_tlvView_t view;
+	phNxpEse_data field;
+
+	if (len < SE050_RECORD_HEADER_LEN || record[0] != SE050_RECORD_VERSION)
+		return APDU_ERROR;
+	bodyLen = record[2] << 8 | record[3];
+	if (SE050_RECORD_HEADER_LEN + bodyLen > len)
+		return APDU_ERROR;
+	*algo = (SE050_AttestationAlgo_t) record[1];
+
+	if (!se050_tlv_decode(&view, body, bodyLen))
+		return APDU_ERROR;
+	if (!se050_tlv_get(&view, SE050_TAG_1, &attestation->data))
+		return APDU_ERROR;
+	if (!se050_tlv_get(&view, SE050_TAG_3, &field) || field.len != 12)
+		return APDU_ERROR;
+	attestation->timeStamp = field.p_data;
+	if (!se050_tlv_get(&view, SE050_TAG_4, &field) || field.len != 16)
+		return APDU_ERROR;
+	attestation->outrandom = field.p_data;
+	if (!se050_tlv_get(&view, SE050_TAG_5, &field) || field.len != 18)
+		return APDU_ERROR;
+	attestation->chipId = field.p_data;
+	/* signature must be the last TLV, preceded by the signed message */
+	if (!se050_tlv_get(&view, SE050_TAG_6, &attestation->signature)
+			|| attestation->signature.p_data + attestation->signature.len
+					!= body + bodyLen)
+		return APDU_ERROR;
+	attestation->message.p_data = view.buff;
+	attestation->message.len = view.offset[SE050_TAG_6 - SE050_TAG_1];
+
+	*recordLen = SE050_RECORD_HEADER_LEN + bodyLen;
+	return APDU_OK;
+}
+
+void se050_recordWriter_init(se050_recordWriter_t *writer, uint8_t *buff,
+		uint32_t size, se050_recordSink_t sink, void *arg) {
+	writer->buff = buff;
+	writer->size = size;
+	writer->len = 0;
+	writer->sink = sink;
+	writer->arg = arg;
+}
+
+apdu_status_t se050_recordWriter_flush(se050_recordWriter_t *writer) {
+
+	apdu_status_t status;
+
+	if (writer->len == 0)
+		return APDU_OK;
+	status = writer->sink(writer->buff, writer->len, writer->arg);
+	writer->len = 0;
+	return status;
+}
+
+apdu_status_t se050_recordWriter_append(se050_recordWriter_t *writer,
+		const attestation_t *attestation, SE050_AttestationAlgo_t algo) {
+
+	uint32_t size = se050_record_size(attestation);
+	uint32_t len;
+	uint8_t header[SE050_RECORD_HEADER_LEN];
+
+	if (size == 0)
+		return APDU_ERROR;
+	if (writer->len + size > writer->size)
+		if (se050_recordWriter_flush(writer) != APDU_OK)
+			return APDU_ERROR;
+
+	if (size > writer->size) {
+		/* stream oversized record directly from the response buffer */
+		setHeader(&header[0], algo, size - SE050_RECORD_HEADER_LEN);
+		if (writer->sink(&header[0], SE050_RECORD_HEADER_LEN, writer->arg)
+				!= APDU_OK)
+			return APDU_ERROR;
+		return writer->sink(attestation->message.p_data,
+				size - SE050_RECORD_HEADER_LEN, writer->arg);
+	}
+
+	len = writer->size - writer->len;
+	if (se050_record_serialize(attestation, algo, &writer->buff[writer->len],
+			&len) != APDU_OK)
+		return APDU_ERROR;
+	writer->len += len;
+	return APDU_OK;
+}
@@ -0,0 +1,142 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_RECORD_H_
+#define SE050_DRV_RECORD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_record.h
+ * @author Michael Grand
+ *
+ * Binary record format of an attested response, used to store or send
+ * attestations once the APDU buffer is reused. A record is a 4-byte header
+ * followed by the attested response as returned by the SE050:
+ *
+ *     version (1) | algo (1) | body length (2, big endian) | body
+ *
+ * where body holds the data, time stamp, random and chip id TLVs (the signed
+ * message) followed by the signature TLV. Writing a record copies the
+ * response as a single slice and reading a record only sets pointers into it,
+ * so a record can be verified with se050_verify() without any copy.
+ */
+
+/// Version of the record format
+#define SE050_RECORD_VERSION 1
+
+/// Length of the record header
+#define SE050_RECORD_HEADER_LEN 4
+
+/**
+ * Callback receiving serialized record bytes, e.g. to append them to a flash
+ * ring buffer or to an uplink queue. A record may be given in several calls.
+ * @param buff Pointer to the bytes to write
+ * @param len Number of bytes to write
+ * @param arg Argument given to the writer
+ * @returns APDU_OK if bytes have been written
+ */
+typedef apdu_status_t (*se050_recordSink_t)(const uint8_t *buff, uint32_t len,
+		void *arg);
+
+/**
+ * Writer packing records in frames of bounded size. A frame is given to the
+ * sink when the next record does not fit in it.
+ */
+typedef struct {
+	/// Frame buffer
+	uint8_t *buff;
+	/// Size of the frame buffer
+	uint32_t size;
+	/// Number of bytes in the frame buffer
+	uint32_t len;
+	/// Frame sink
+	se050_recordSink_t sink;
+	/// Argument of the sink
+	void *arg;
+} se050_recordWriter_t;
+
+/**
+ * Get the length of the record of an attestation.
+ * @param attestation Pointer to an attestation returned by this driver
+ * @returns length of the record, 0 if the attestation cannot be serialized
+ */
+uint32_t se050_record_size(const attestation_t *attestation);
+
+/**
+ * Serialize an attestation in a buffer.
+ * @param attestation Pointer to an attestation returned by this driver
+ * @param algo Algorithm used for the attestation generation
+ * @param buff Buffer receiving the record
+ * @param len Size of buff on input, length of the record on output
+ * @returns APDU_ERROR if the record does not fit in buff
+ */
+apdu_status_t se050_record_serialize(const attestation_t *attestation,
+		SE050_AttestationAlgo_t algo, uint8_t *buff, uint32_t *len);
+
+/**
+ * Read a record without copy. Pointers of the attestation point into the
+ * record buffer.
+ * @param record Pointer to the record
+ * @param len Number of bytes available from record
+ * @param algo Pointer receiving the attestation algorithm
+ * @param attestation Pointer to the attestation structure to fill
+ * @param recordLen Pointer receiving the length of the record, used to go to the next record
+ * @returns APDU_ERROR if the record is truncated, malformed or of an unknown version
+ */
+apdu_status_t se050_record_read(const uint8_t *record, uint32_t len,
+		SE050_AttestationAlgo_t *algo, attestation_t *attestation,
+		uint32_t *recordLen);
+
+/**
+ * Initialize a record writer.
+ * @param writer Pointer to a writer structure
+ * @param buff Frame buffer (e.g. sized to the uplink payload)
+ * @param size Size of the frame buffer
+ * @param sink Callback receiving frames
+ * @param arg Argument passed to the sink
+ */
+void se050_recordWriter_init(se050_recordWriter_t *writer, uint8_t *buff,
+		uint32_t size, se050_recordSink_t sink, void *arg);
+
+/**
+ * Append the record of an attestation to the current frame. The frame is
+ * flushed first if the record does not fit in it. A record larger than the
+ * frame buffer is given directly to the sink.
+ * @param writer Pointer to an initialized writer structure
+ * @param attestation Pointer to an attestation returned by this driver
+ * @param algo Algorithm used for the attestation generation
+ * @returns status indicating if the record has been written
+ */
+apdu_status_t se050_recordWriter_append(se050_recordWriter_t *writer,
+		const attestation_t *attestation, SE050_AttestationAlgo_t algo);
+
+/**
+ * Give the current frame to the sink, if not empty.
+ * @param writer Pointer to an initialized writer structure
+ * @returns status returned by the sink
+ */
+apdu_status_t se050_recordWriter_flush(se050_recordWriter_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_RECORD_H_ */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_sampler.h"
+#include <string.h>
+
+static void restartChain(se050_sampler_t *sampler) {
+	mbedtls_sha256_starts_ret(&sampler->chain, 0);
+	mbedtls_sha256_update_ret(&sampler->chain, &sampler->random[0], 16);
+	sampler->count = 0;
+}
+
+void se050_sampler_init(se050_sampler_t *sampler, uint16_t attestEvery,
+		const uint8_t *random) {
+
+	memset(sampler, 0, sizeof(se050_sampler_t));
+	sampler->attestEvery = (attestEvery > 0) ? attestEvery : 1;
+	memcpy(&sampler->random[0], random, 16);
+	mbedtls_sha256_init(&sampler->chain);
+	restartChain(sampler);
+}
+
+void se050_sampler_free(se050_sampler_t *sampler) {
+	mbedtls_sha256_free(&sampler->chain);
+}
+
+apdu_status_t se050_sampler_read(se050_sampler_t *sampler, i2cm_tlv_t *tlv,
+		uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
+		attestation_t *attestation, bool *attested, apdu_ctx_t *ctx) {
+
+	*attested = false;
+
+	if (sampler->count + 1 < sampler->attestEvery) {
+		phNxpEse_data data;
+		if (se050_i2cm_cmds(tlv, sz_tlv, &data, ctx) != APDU_OK)
+			return APDU_ERROR;
+		mbedtls_sha256_update_ret(&sampler->chain, data.p_data, data.len);
+		sampler->count++;
+		sampler->plain++;
+		return APDU_OK;
+	}
+
+	/* finish a copy so that the chain is kept if the attested read fails */
+	mbedtls_sha256_context chain;
+	uint8_t digest[32];
+	int ret;
+	mbedtls_sha256_init(&chain);
+	mbedtls_sha256_clone(&chain, &sampler->chain);
+	ret = mbedtls_sha256_finish_ret(&chain, &digest[0]);
+	mbedtls_sha256_free(&chain);
+	if (ret != 0) {
+		/* never attest with a predictable random */
+		sampler->randomFailures++;
+		return APDU_ERROR;
+	}
+
+	if (se050_i2cm_attestedCmds(0, 0, tlv, sz_tlv, algo, &digest[0],
+			attestation, ctx) != APDU_OK)
+		return APDU_ERROR;
+
+	memcpy(&sampler->random[0], &digest[0], 16);
+	restartChain(sampler);
+	sampler->attested++;
+	*attested = true;
+	return APDU_OK;
+}
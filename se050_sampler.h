@@ -0,0 +1,104 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_SAMPLER_H_
+#define SE050_DRV_SAMPLER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+#include "mbedtls/sha256.h"
+
+/**
+ * @file se050_sampler.h
+ * @author Michael Grand
+ *
+ * Hybrid I2CM sampling: only one read out of attestEvery is attested, other
+ * reads use the non-attested I2CM command and cost no signature.
+ *
+ * Non-attested responses are chained in a rolling SHA-256 hash which is
+ * committed by the next attestation. The 16-byte random sent with an attested
+ * read is:
+ *
+ *     random_k = SHA-256(random_k-1 || data_1 || ... || data_n)[0..15]
+ *
+ * where random_0 is the random given to se050_sampler_init() and data_i are
+ * the raw I2CM responses (TAG_1 value) of the non-attested reads since the
+ * previous attestation. The SE050 returns this random in the attestation, so
+ * a verifier knowing random_0 can check that the non-attested samples it
+ * received are those the host committed to before each attestation. Samples
+ * which are not attested are still not proven to come from the sensor.
+ */
+
+/**
+ * Hybrid sampler state.
+ */
+typedef struct {
+	/// One read out of attestEvery is attested
+	uint16_t attestEvery;
+	/// Number of non-attested reads since the last attestation
+	uint16_t count;
+	/// Random sent with the last attested read (or initial random)
+	uint8_t random[16];
+	/// Rolling hash of non-attested responses
+	mbedtls_sha256_context chain;
+	/// Number of attested reads
+	uint32_t attested;
+	/// Number of non-attested reads
+	uint32_t plain;
+	/// Number of attested reads skipped because their random could not be computed
+	uint32_t randomFailures;
+} se050_sampler_t;
+
+/**
+ * Initialize a hybrid sampler.
+ * @param sampler Pointer to a sampler structure
+ * @param attestEvery One read out of attestEvery is attested (1 to attest all reads)
+ * @param random Pointer to a 16-byte initial random
+ */
+void se050_sampler_init(se050_sampler_t *sampler, uint16_t attestEvery,
+		const uint8_t *random);
+
+/**
+ * Release resources used by a sampler.
+ * @param sampler Pointer to an initialized sampler structure
+ */
+void se050_sampler_free(se050_sampler_t *sampler);
+
+/**
+ * Execute a set of I2CM commands, attested or not depending on the number of
+ * reads since the last attestation.
+ * @param sampler Pointer to an initialized sampler structure
+ * @param tlv Pointer to an array of I2C commands (including configuration command)
+ * @param sz_tlv Size of the tlv array
+ * @param algo Algorithm which has to be used for the attestation generation
+ * @param attestation Pointer to an attestation structure, filled for attested reads only
+ * @param attested Set to true if the read has been attested
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns status indicating if commands have been executed (APDU_ERROR without
+ * sending any command if the random of an attested read cannot be computed)
+ */
+apdu_status_t se050_sampler_read(se050_sampler_t *sampler, i2cm_tlv_t *tlv,
+		uint8_t sz_tlv, SE050_AttestationAlgo_t algo,
+		attestation_t *attestation, bool *attested, apdu_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_SAMPLER_H_ */
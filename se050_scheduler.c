@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_scheduler.h"
+#include "platform/timer.h"
+
+void se050_scheduler_init(se050_scheduler_t *sched,
+		se050_i2cmPrepared_t *prepared, uint32_t period,
+		se050_randomSource_t random, se050_sampleSink_t sink, void *arg) {
+
+	sched->prepared = prepared;
+	sched->period = period;
+	sched->random = random;
+	sched->sink = sink;
+	sched->arg = arg;
+	sched->next = se050_timer_us() + period;
+	se050_scheduler_resetStats(sched);
+}
+
+void se050_scheduler_resetStats(se050_scheduler_t *sched) {
+	sched->samples = 0;
+	sched->overruns = 0;
+	sched->randomFailures = 0;
+	sched->jitterMin = UINT32_MAX;
+	sched->jitterMax = 0;
+	sched->jitterSum = 0;
+}
+
+apdu_status_t se050_scheduler_run(se050_scheduler_t *sched, uint32_t nSamples,
+		apdu_ctx_t *ctx) {
+
+	uint8_t random[16];
+	attestation_t attestation;
+
+	for (uint32_t n = 0; nSamples == 0 || n < nSamples; n++) {
+		uint32_t deadline = sched->next;
+
+		/* random is computed before the deadline, it is not time critical */
+		if (sched->random(&random[0], sched->arg) != APDU_OK) {
+			/* never attest with a predictable random */
+			sched->randomFailures++;
+		} else {
+			se050_timer_sleepUntil(deadline);
+
+			uint32_t jitter = se050_timer_us() - deadline;
+			if (jitter < sched->jitterMin)
+				sched->jitterMin = jitter;
+			if (jitter > sched->jitterMax)
+				sched->jitterMax = jitter;
+			sched->jitterSum += jitter;
+			sched->samples++;
+
+			if (se050_i2cm_issue(sched->prepared, &random[0], &attestation,
+					ctx) != APDU_OK)
+				return APDU_ERROR;
+			if (sched->sink(sched->prepared, &attestation, deadline,
+					sched->arg) != APDU_OK)
+				return APDU_ERROR;
+		}
+
+		/* skip deadlines which are already passed */
+		sched->next += sched->period;
+		while ((int32_t) (se050_timer_us() - sched->next) > 0) {
+			sched->next += sched->period;
+			sched->overruns++;
+		}
+	}
+	return APDU_OK;
+}
@@ -0,0 +1,117 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_SCHEDULER_H_
+#define SE050_DRV_SCHEDULER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+
+/**
+ * @file se050_scheduler.h
+ * @author Michael Grand
+ *
+ * Issue a prepared attested I2CM command (see se050_i2cm_prepare()) at a
+ * fixed period. Deadlines are absolute, so execution time of a sample does not
+ * shift the following ones. The delay between each deadline and the actual
+ * start of the sample is recorded as jitter.
+ */
+
+/**
+ * Callback filling the 16-byte random of the next sample.
+ * @returns APDU_ERROR if no random is available, the sample is then skipped
+ */
+typedef apdu_status_t (*se050_randomSource_t)(uint8_t *random, void *arg);
+
+/**
+ * Callback receiving a sample. Responses and attestation point to the APDU
+ * buffer and are only valid during the call.
+ * @param prepared Prepared command whose tlv array holds the responses
+ * @param attestation Pointer to the attestation of the sample
+ * @param deadline Scheduled start time of the sample (se050_timer_us() value)
+ * @param arg Argument given to se050_scheduler_init()
+ * @returns APDU_OK to continue sampling
+ */
+typedef apdu_status_t (*se050_sampleSink_t)(const se050_i2cmPrepared_t *prepared,
+		const attestation_t *attestation, uint32_t deadline, void *arg);
+
+/**
+ * Periodic sampling scheduler.
+ */
+typedef struct {
+	/// Prepared command issued at each period
+	se050_i2cmPrepared_t *prepared;
+	/// Sampling period in microseconds
+	uint32_t period;
+	/// Deadline of the next sample
+	uint32_t next;
+	/// Random source
+	se050_randomSource_t random;
+	/// Sample sink
+	se050_sampleSink_t sink;
+	/// Argument of the callbacks
+	void *arg;
+	/// Number of samples
+	uint32_t samples;
+	/// Number of periods skipped because a sample lasted longer than a period
+	uint32_t overruns;
+	/// Number of samples skipped because the random source failed
+	uint32_t randomFailures;
+	/// Minimum start delay in microseconds
+	uint32_t jitterMin;
+	/// Maximum start delay in microseconds
+	uint32_t jitterMax;
+	/// Sum of start delays in microseconds
+	uint64_t jitterSum;
+} se050_scheduler_t;
+
+/**
+ * Initialize a sampling scheduler. The first sample is due one period after this call.
+ * @param sched Pointer to a scheduler structure
+ * @param prepared Pointer to a prepared attested I2CM command
+ * @param period Sampling period in microseconds
+ * @param random Callback filling the random of each sample
+ * @param sink Callback receiving each sample
+ * @param arg Argument passed to callbacks
+ */
+void se050_scheduler_init(se050_scheduler_t *sched,
+		se050_i2cmPrepared_t *prepared, uint32_t period,
+		se050_randomSource_t random, se050_sampleSink_t sink, void *arg);
+
+/**
+ * Run the scheduler.
+ * @param sched Pointer to an initialized scheduler structure
+ * @param nSamples Number of periods to run, including samples skipped by the random source, 0 to run until the sink returns an error
+ * @param ctx Pointer to an initialized APDU context structure
+ * @returns APDU_OK when nSamples samples have been taken
+ */
+apdu_status_t se050_scheduler_run(se050_scheduler_t *sched, uint32_t nSamples,
+		apdu_ctx_t *ctx);
+
+/**
+ * Reset jitter statistics.
+ * @param sched Pointer to an initialized scheduler structure
+ */
+void se050_scheduler_resetStats(se050_scheduler_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_SCHEDULER_H_ */
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_tlv.h"
+#include <string.h>
+
+uint32_t se050_tlv_headerLen(uint32_t len) {
+	if (len > 0xFF)
+		return 4;
+	else if (len > 0x7F)
+		return 3;
+	else
+		return 2;
+}
+
+void se050_tlv_initWriter(se050_tlvWriter_t *writer, uint8_t *buff,
+		uint32_t size) {
+	writer->buff = buff;
+	writer->size = size;
+	writer->len = 0;
+	writer->overflow = false;
+}
+
+uint8_t* se050_tlv_reserve(se050_tlvWriter_t *writer, uint32_t len) {
+
+	uint8_t *p;
+
+	if (writer->overflow || len > writer->size - writer->len) {
+		writer->overflow = true;
+		return NULL;
+	}
+	p = &writer->buff[writer->len];
+	writer->len += len;
+	return p;
+}
+
+void se050_tlv_putHeader(se050_tlvWriter_t *writer, uint8_t tag, uint32_t len,
+		bool fixed) {
+
+	uint32_t hdrLen = (fixed) ? 3 : se050_tlv_headerLen(len);
+	uint8_t *p;
+
+	if (len > 0xFFFF
+			|| (p = se050_tlv_reserve(writer, hdrLen)) == NULL) {
+		writer->overflow = true;
+		return;
+	}
+
+	*p++ = tag;
+	if (fixed) {
+		*p++ = (len & 0xFF00) >> 8;
+	} else if (len > 0xFF) {
+		*p++ = 0x82;
+		*p++ = (len & 0xFF00) >> 8;
+	} else if (len > 0x7F) {
+		*p++ = 0x81;
+	}
+	*p = len & 0xFF;
+}
+
+void se050_tlv_putRaw(se050_tlvWriter_t *writer, const uint8_t *data,
+		uint32_t len) {
+
+	uint8_t *p = se050_tlv_reserve(writer, len);
+	if (p != NULL && len > 0)
+		memmove(p, data, len);
+}
+
+void se050_tlv_putArray(se050_tlvWriter_t *writer, uint8_t tag,
+		const uint8_t *data, uint32_t len) {
+	se050_tlv_putHeader(writer, tag, len, false);
+	se050_tlv_putRaw(writer, data, len);
+}
+
+void se050_tlv_putU8(se050_tlvWriter_t *writer, uint8_t tag, uint8_t value) {
+	se050_tlv_putArray(writer, tag, &value, 1);
+}
+
+void se050_tlv_putU16(se050_tlvWriter_t *writer, uint8_t tag, uint16_t value) {
+	const uint8_t data[] = { (value & 0xFF00) >> 8, value & 0x00FF };
+	se050_tlv_putArray(writer, tag, &data[0], sizeof(data));
+}
+
+void se050_tlv_putU32(se050_tlvWriter_t *writer, uint8_t tag, uint32_t value) {
+	const uint8_t data[] = { (value & 0xFF000000) >> 24, (value & 0x00FF0000)
+			>> 16, (value & 0x0000FF00) >> 8, value & 0x000000FF };
+	se050_tlv_putArray(writer, tag, &data[0], sizeof(data));
+}
+
+bool se050_tlv_finish(const se050_tlvWriter_t *writer, uint32_t *len) {
+	*len = writer->len;
+	return !writer->overflow;
+}
+
+bool se050_tlv_decode(se050_tlvView_t *view, const uint8_t *buff,
+		uint32_t len) {
+
+	uint32_t i = 0;
+
+	view->buff = (uint8_t*) buff;
+	view->present = 0;
+	while (i < len) {
+		uint32_t start = i;
+		uint32_t valueLen;
+		uint8_t idx = buff[i++] - SE050_TAG_1;
+
+		if (idx >= SE050_TLV_VIEW_TAGS || (view->present & (1 << idx))
+				|| i >= len)
+			return false;
+
+		if (buff[i] == 0x82) {
+			if (i + 3 > len)
+				return false;
+			valueLen = buff[i + 1] << 8 | buff[i + 2];
+			i += 3;
+		} else if (buff[i] == 0x81) {
+			if (i + 2 > len)
+				return false;
+			valueLen = buff[i + 1];
+			i += 2;
+		} else if (buff[i] < 0x80) {
+			valueLen = buff[i];
+			i += 1;
+		} else {
+			return false;
+		}
+		if (valueLen > len - i)
+			return false;
+
+		view->field[idx].p_data = &view->buff[i];
+		view->field[idx].len = valueLen;
+		view->offset[idx] = start;
+		view->present |= 1 << idx;
+		i += valueLen;
+	}
+	return true;
+}
+
+bool se050_tlv_get(const se050_tlvView_t *view, SE050_TAG_t tag,
+		phNxpEse_data *value) {
+
+	uint8_t idx = tag - SE050_TAG_1;
+
+	if (idx >= SE050_TLV_VIEW_TAGS || !(view->present & (1 << idx)))
+		return false;
+	*value = view->field[idx];
+	return true;
+}
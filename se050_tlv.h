@@ -0,0 +1,193 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_TLV_H_
+#define SE050_DRV_TLV_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "T1oI2C/phNxpEse_Api.h"
+#include "se050_enums.h"
+
+/**
+ * @file se050_tlv.h
+ * @author Michael Grand
+ *
+ * TLV codec used to build SE050 commands and to parse their responses.
+ *
+ * The writer encodes TLVs forward in a bounded buffer. Once an encoding
+ * does not fit, the writer is marked as overflowed and stops writing, so
+ * that a command can be built without checking each call and rejected once
+ * by se050_tlv_finish().
+ *
+ * The decoder parses a response in a single pass into a view indexed by
+ * tag (SE050_TAG_1 to SE050_TAG_7), values are not copied.
+ *
+ * Lengths use BER encoding (0x81/0x82 prefix above 127 bytes), except
+ * I2CM commands which use a fixed 2-byte length.
+ */
+
+/**
+ * Number of tags indexed by a TLV view (SE050_TAG_1 to SE050_TAG_7).
+ */
+#define SE050_TLV_VIEW_TAGS 7
+
+/**
+ * TLV writer.
+ */
+typedef struct {
+	/// Output buffer
+	uint8_t *buff;
+	/// Size of the output buffer
+	uint32_t size;
+	/// Number of bytes written
+	uint32_t len;
+	/// Set once an encoding did not fit in the buffer
+	bool overflow;
+} se050_tlvWriter_t;
+
+/**
+ * TLV view of a response.
+ */
+typedef struct {
+	/// Value of each tag, indexed by tag - SE050_TAG_1
+	phNxpEse_data field[SE050_TLV_VIEW_TAGS];
+	/// Parsed buffer
+	uint8_t *buff;
+	/// Offset of each TLV in the parsed buffer
+	uint32_t offset[SE050_TLV_VIEW_TAGS];
+	/// Bit k is set if tag SE050_TAG_1 + k is present
+	uint8_t present;
+} se050_tlvView_t;
+
+/**
+ * Get the length of a BER-TLV header.
+ * @param len Length of the value
+ * @returns length of tag and length fields
+ */
+uint32_t se050_tlv_headerLen(uint32_t len);
+
+/**
+ * Initialize a TLV writer.
+ * @param writer Pointer to a writer structure
+ * @param buff Output buffer
+ * @param size Size of the output buffer
+ */
+void se050_tlv_initWriter(se050_tlvWriter_t *writer, uint8_t *buff,
+		uint32_t size);
+
+/**
+ * Write a TLV header, the value has to be written next.
+ * @param writer Pointer to an initialized writer structure
+ * @param tag Tag
+ * @param len Length of the value
+ * @param fixed True to write the length on two bytes (I2CM commands), false for BER encoding
+ */
+void se050_tlv_putHeader(se050_tlvWriter_t *writer, uint8_t tag, uint32_t len,
+		bool fixed);
+
+/**
+ * Write raw bytes.
+ * @param writer Pointer to an initialized writer structure
+ * @param data Bytes to write
+ * @param len Number of bytes
+ */
+void se050_tlv_putRaw(se050_tlvWriter_t *writer, const uint8_t *data,
+		uint32_t len);
+
+/**
+ * Reserve bytes to be filled by the caller, e.g. to read a chunk of data directly in place.
+ * @param writer Pointer to an initialized writer structure
+ * @param len Number of bytes
+ * @returns pointer to the reserved bytes, NULL if they do not fit
+ */
+uint8_t* se050_tlv_reserve(se050_tlvWriter_t *writer, uint32_t len);
+
+/**
+ * Write a TLV holding an array.
+ * @param writer Pointer to an initialized writer structure
+ * @param tag Tag
+ * @param data Value
+ * @param len Length of the value
+ */
+void se050_tlv_putArray(se050_tlvWriter_t *writer, uint8_t tag,
+		const uint8_t *data, uint32_t len);
+
+/**
+ * Write a TLV holding a 1-byte value.
+ * @param writer Pointer to an initialized writer structure
+ * @param tag Tag
+ * @param value Value
+ */
+void se050_tlv_putU8(se050_tlvWriter_t *writer, uint8_t tag, uint8_t value);
+
+/**
+ * Write a TLV holding a 2-byte big endian value.
+ * @param writer Pointer to an initialized writer structure
+ * @param tag Tag
+ * @param value Value
+ */
+void se050_tlv_putU16(se050_tlvWriter_t *writer, uint8_t tag, uint16_t value);
+
+/**
+ * Write a TLV holding a 4-byte big endian value.
+ * @param writer Pointer to an initialized writer structure
+ * @param tag Tag
+ * @param value Value
+ */
+void se050_tlv_putU32(se050_tlvWriter_t *writer, uint8_t tag, uint32_t value);
+
+/**
+ * Check that all encodings fit in the buffer.
+ * @param writer Pointer to an initialized writer structure
+ * @param len Pointer receiving the number of bytes written
+ * @returns false if the buffer overflowed
+ */
+bool se050_tlv_finish(const se050_tlvWriter_t *writer, uint32_t *len);
+
+/**
+ * Parse a sequence of TLVs. Each tag must be in the SE050_TAG_1 to
+ * SE050_TAG_7 range and appear once, and the last TLV must end with the buffer.
+ * The buffer is only read. The view points into it through phNxpEse_data,
+ * which has no const variant: values must not be written when the buffer is
+ * read-only.
+ * @param view Pointer to the view to fill
+ * @param buff Buffer to parse
+ * @param len Length of the buffer
+ * @returns false if the buffer is malformed
+ */
+bool se050_tlv_decode(se050_tlvView_t *view, const uint8_t *buff,
+		uint32_t len);
+
+/**
+ * Get the value of a tag from a view.
+ * @param view Pointer to a view filled by se050_tlv_decode()
+ * @param tag Tag
+ * @param value Structure receiving a pointer to the value and its length
+ * @returns false if the tag is not present
+ */
+bool se050_tlv_get(const se050_tlvView_t *view, SE050_TAG_t tag,
+		phNxpEse_data *value);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_TLV_H_ */
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_verify.h"
+
+/*
+ * Resolve the hash function and signature scheme of an attestation algorithm.
+ */
+static bool getScheme(SE050_AttestationAlgo_t algo, mbedtls_md_type_t *md,
+		mbedtls_pk_type_t *type) {
+
+	switch (algo) {
+	case SE050_AttestationAlgo_EC_SHA:
+		*md = MBEDTLS_MD_SHA1;
+		*type = MBEDTLS_PK_ECDSA;
+		return true;
+	case SE050_AttestationAlgo_EC_SHA_224:
+		*md = MBEDTLS_MD_SHA224;
+		*type = MBEDTLS_PK_ECDSA;
+		return true;
+	case SE050_AttestationAlgo_EC_SHA_256:
+		*md = MBEDTLS_MD_SHA256;
+		*type = MBEDTLS_PK_ECDSA;
+		return true;
+	case SE050_AttestationAlgo_EC_SHA_384:
+		*md = MBEDTLS_MD_SHA384;
+		*type = MBEDTLS_PK_ECDSA;
+		return true;
+	case SE050_AttestationAlgo_EC_SHA_512:
+		*md = MBEDTLS_MD_SHA512;
+		*type = MBEDTLS_PK_ECDSA;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA1_PKCS1_PSS:
+		*md = MBEDTLS_MD_SHA1;
+		*type = MBEDTLS_PK_RSASSA_PSS;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA224_PKCS1_PSS:
+		*md = MBEDTLS_MD_SHA224;
+		*type = MBEDTLS_PK_RSASSA_PSS;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA256_PKCS1_PSS:
+		*md = MBEDTLS_MD_SHA256;
+		*type = MBEDTLS_PK_RSASSA_PSS;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA384_PKCS1_PSS:
+		*md = MBEDTLS_MD_SHA384;
+		*type = MBEDTLS_PK_RSASSA_PSS;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA512_PKCS1_PSS:
+		*md = MBEDTLS_MD_SHA512;
+		*type = MBEDTLS_PK_RSASSA_PSS;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA_224_PKCS1:
+		*md = MBEDTLS_MD_SHA224;
+		*type = MBEDTLS_PK_RSA;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA_256_PKCS1:
+		*md = MBEDTLS_MD_SHA256;
+		*type = MBEDTLS_PK_RSA;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA_384_PKCS1:
+		*md = MBEDTLS_MD_SHA384;
+		*type = MBEDTLS_PK_RSA;
+		return true;
+	case SE050_AttestationAlgo_RSA_SHA_512_PKCS1:
+		*md = MBEDTLS_MD_SHA512;
+		*type = MBEDTLS_PK_RSA;
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool verifyOne(se050_verifier_t *verifier, const mbedtls_md_info_t *mdInfo,
+		mbedtls_md_type_t md, mbedtls_pk_type_t type,
+		const attestation_t *attestation) {
+
+	uint8_t hash[MBEDTLS_MD_MAX_SIZE];
+	int ret;
+
+	if (attestation->message.p_data == NULL
+			|| attestation->signature.p_data == NULL)
+		return false;
+	if (mbedtls_md(mdInfo, attestation->message.p_data,
+			attestation->message.len, &hash[0]) != 0)
+		return false;
+
+	if (type == MBEDTLS_PK_RSASSA_PSS) {
+		mbedtls_pk_rsassa_pss_options options;
+		options.mgf1_hash_id = md;
+		options.expected_salt_len = MBEDTLS_RSA_SALT_LEN_ANY;
+		ret = mbedtls_pk_verify_ext(type, &options, &verifier->pk, md,
+				&hash[0], mbedtls_md_get_size(mdInfo),
+				attestation->signature.p_data, attestation->signature.len);
+	} else {
+		ret = mbedtls_pk_verify(&verifier->pk, md, &hash[0],
+				mbedtls_md_get_size(mdInfo), attestation->signature.p_data,
+				attestation->signature.len);
+	}
+	return ret == 0;
+}
+
+apdu_status_t se050_verifier_init(se050_verifier_t *verifier,
+		const uint8_t *pubKey, uint32_t len) {
+
+	mbedtls_pk_init(&verifier->pk);
+	if (mbedtls_pk_parse_public_key(&verifier->pk, pubKey, len) != 0) {
+		mbedtls_pk_free(&verifier->pk);
+		return APDU_ERROR;
+	}
+	return APDU_OK;
+}
+
+void se050_verifier_free(se050_verifier_t *verifier) {
+	mbedtls_pk_free(&verifier->pk);
+}
+
+apdu_status_t se050_verify(se050_verifier_t *verifier,
+		SE050_AttestationAlgo_t algo, const attestation_t *attestation) {
+	return se050_verifyBatch(verifier, algo, attestation, 1, NULL);
+}
+
+apdu_status_t se050_verifyBatch(se050_verifier_t *verifier,
+		SE050_AttestationAlgo_t algo, const attestation_t *attestations,
+		uint32_t n, bool *valid) {
+
+	mbedtls_md_type_t md;
+	mbedtls_pk_type_t type;
+	const mbedtls_md_info_t *mdInfo;
+	apdu_status_t status = APDU_OK;
+
+	if (!getScheme(algo, &md, &type)
+			|| !mbedtls_pk_can_do(&verifier->pk,
+					(type == MBEDTLS_PK_ECDSA) ? MBEDTLS_PK_ECDSA : MBEDTLS_PK_RSA)
+			|| (mdInfo = mbedtls_md_info_from_type(md)) == NULL) {
+		if (valid != NULL)
+			for (uint32_t k = 0; k < n; k++)
+				valid[k] = false;
+		return APDU_ERROR;
+	}
+
+	for (uint32_t k = 0; k < n; k++) {
+		bool ok = verifyOne(verifier, mdInfo, md, type, &attestations[k]);
+		if (valid != NULL)
+			valid[k] = ok;
+		if (!ok)
+			status = APDU_ERROR;
+	}
+	return status;
+}
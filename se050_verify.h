@@ -0,0 +1,95 @@
+/*
+ * @copyright Copyright (c) 2020, Michael Grand
+ * @license SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SE050_DRV_VERIFY_H_
+#define SE050_DRV_VERIFY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "apdu.h"
+#include "mbedtls/pk.h"
+
+/**
+ * @file se050_verify.h
+ * @author Michael Grand
+ *
+ * Verification of attestation signatures with the public part of the
+ * attestation key. The signed message is the attested response up to the
+ * signature TLV (attestation_t.message), it is hashed in place.
+ *
+ * Supported algorithms are ECDSA with SHA-1/224/256/384/512, RSA PKCS#1 v1.5
+ * and RSA PSS. EC_PLAIN, ED25519PH and ECDAA attestations are rejected as
+ * they are not supported by mbedtls.
+ */
+
+/**
+ * Attestation verifier.
+ */
+typedef struct {
+	/// Parsed attestation public key
+	mbedtls_pk_context pk;
+} se050_verifier_t;
+
+/**
+ * Initialize a verifier with the public part of an attestation key.
+ * @param verifier Pointer to a verifier structure
+ * @param pubKey DER encoded public key (as returned by se050_readObject())
+ * @param len Length of the public key
+ * @returns APDU_ERROR if the key cannot be parsed
+ */
+apdu_status_t se050_verifier_init(se050_verifier_t *verifier,
+		const uint8_t *pubKey, uint32_t len);
+
+/**
+ * Release resources used by a verifier.
+ * @param verifier Pointer to an initialized verifier structure
+ */
+void se050_verifier_free(se050_verifier_t *verifier);
+
+/**
+ * Verify an attestation.
+ * @param verifier Pointer to an initialized verifier structure
+ * @param algo Algorithm used for the attestation generation
+ * @param attestation Pointer to the attestation to verify
+ * @returns APDU_OK if the signature is valid
+ */
+apdu_status_t se050_verify(se050_verifier_t *verifier,
+		SE050_AttestationAlgo_t algo, const attestation_t *attestation);
+
+/**
+ * Verify a set of attestations generated with the same key and algorithm.
+ * The key is parsed and the algorithm resolved once for the whole set, then
+ * each signature is verified on its own: ECDSA and RSA signatures cannot be
+ * verified as a batch, and ED25519PH (the only algorithm which would allow it)
+ * is rejected, so this is a convenience loop over se050_verify().
+ * @param verifier Pointer to an initialized verifier structure
+ * @param algo Algorithm used for the attestation generation
+ * @param attestations Array of attestations to verify
+ * @param n Size of the attestations array
+ * @param valid Array of n booleans receiving the result of each verification, may be NULL
+ * @returns APDU_OK if all signatures are valid
+ */
+apdu_status_t se050_verifyBatch(se050_verifier_t *verifier,
+		SE050_AttestationAlgo_t algo, const attestation_t *attestations,
+		uint32_t n, bool *valid);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SE050_DRV_VERIFY_H_ */
@@ -0,0 +1,808 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host microbenchmarks of the driver, run against the simulated SE050 of
+ * tools/sim:
+ *   crc         frame CRC throughput
+ *   tlv_encode  encoding of attested I2CM commands (se050_i2cm_prepare)
+ *   tlv_decode  decoding of attested I2CM responses (se050_tlv_decode and
+ *               se050_i2cm_getRsps)
+ *   attested    attested I2CM round trip (se050_i2cm_issue)
+ *   chain       chained APDU round trip for several IFSC
+ *   object      binary object write and read throughput
+ *               (se050_writeBinaryStream and se050_readObjectStream)
+ *   latency     APDU round trip for several SE050 processing times
+ *   pipeline    commands sent through se050_pipeline_run versus one after the
+ *               other, for several host processing times per command
+ *   worker      latency of high priority worker requests while a low priority
+ *               job streams objects without pause
+ *
+ * Except for latency, pipeline and worker, polling delays are not waited for, so results
+ * measure the host processing time. Each result is printed as a JSON object on its
+ * own line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "apdu.h"
+#include "apdu_internal.h"
+#include "se050_tlv.h"
+#include "phNxpEse_Api.h"
+#include "platform/worker.h"
+#include "platform/reset.h"
+#include "se050_sim.h"
+#include "se050_sim_store.h"
+#include "platform/timer.h"
+
+#define MAX_SAMPLES	31
+#define MAX_BATCH	64
+#define MAX_ROUND_TRIPS	1000
+#define OBJECT_ID	0x7FFF0100
+/// Processing time of a simulated APDU for the worker benchmark
+#define WORKER_LATENCY_US	2000
+
+uint16_t bench_crc(uint8_t *data, uint32_t len);
+
+typedef void (*benchFn_t)(void *arg, uint32_t iterations);
+
+typedef struct {
+	/// Iterations per sample
+	uint32_t iterations;
+	/// Median time of an iteration
+	double nsPerOp;
+	/// Fastest time of an iteration
+	double nsPerOpMin;
+} result_t;
+
+static uint32_t samples = 7;
+static uint32_t sampleMs = 20;
+static uint32_t roundTrips = 20;
+static const char *filter;
+/// Wait for polling delays
+static int realDelays;
+static volatile uint32_t sink;
+
+static se050_sim_t sim;
+static apdu_ctx_t ctx;
+
+static uint64_t nowNs(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void thread_sleep_for(uint32_t millisec) {
+	struct timespec ts = { millisec / 1000, (millisec % 1000) * 1000000L };
+
+	if (realDelays)
+		nanosleep(&ts, NULL);
+}
+
+void wait_ms(int ms) {
+	thread_sleep_for(ms);
+}
+
+uint32_t se050_timer_us(void) {
+	return nowNs() / 1000;
+}
+
+void se050_powerOn(void) {
+}
+
+void se050_powerOff(void) {
+}
+
+static int compare(const void *a, const void *b) {
+	double x = *(const double*) a;
+	double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Run fn in samples lasting at least sampleMs.
+ */
+static void measure(benchFn_t fn, void *arg, result_t *result) {
+	double ns[MAX_SAMPLES];
+	uint64_t t;
+	uint32_t n = 1;
+
+	for (;;) {
+		t = nowNs();
+		fn(arg, n);
+		t = nowNs() - t;
+		if (t >= sampleMs * 1000000ull || n >= (1u << 30))
+			break;
+		n *= 2;
+	}
+	for (uint32_t k = 0; k < samples; k++) {
+		t = nowNs();
+		fn(arg, n);
+		ns[k] = (double) (nowNs() - t) / n;
+	}
+	qsort(ns, samples, sizeof(ns[0]), compare);
+	result->iterations = n;
+	result->nsPerOp = ns[samples / 2];
+	result->nsPerOpMin = ns[0];
+}
+
+static int selected(const char *name) {
+	return filter == NULL || strcmp(filter, name) == 0;
+}
+
+static void printResult(const result_t *result) {
+	printf("\"iterations\":%u,\"ns_per_op\":%.1f,\"ns_per_op_min\":%.1f",
+			result->iterations, result->nsPerOp, result->nsPerOpMin);
+}
+
+static uint32_t frames(void) {
+	phNxpEse_stats_t stats;
+
+	phNxpEse_getStats(&stats);
+	return stats.framesSent + stats.framesReceived;
+}
+
+/*
+ * CRC
+ */
+typedef struct {
+	uint8_t data[259];
+	uint32_t len;
+} crcArg_t;
+
+static void runCrc(void *arg, uint32_t iterations) {
+	crcArg_t *crc = arg;
+	uint16_t acc = 0;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		acc ^= bench_crc(crc->data, crc->len);
+	sink = acc;
+}
+
+static void benchCrc(void) {
+	static const uint32_t lens[] = { 5, 64, 259 };
+	crcArg_t crc;
+	result_t result;
+
+	for (uint32_t k = 0; k < sizeof(crc.data); k++)
+		crc.data[k] = k;
+	for (uint32_t k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+		crc.len = lens[k];
+		measure(runCrc, &crc, &result);
+		printf("{\"bench\":\"crc\",\"len\":%u,", crc.len);
+		printResult(&result);
+		printf(",\"mb_per_s\":%.2f}\n", crc.len * 1e3 / result.nsPerOp);
+	}
+}
+
+/*
+ * Attested I2CM commands
+ */
+typedef struct {
+	i2cm_tlv_t tlv[2 * MAX_BATCH];
+	uint8_t sz_tlv;
+	se050_i2cmPrepared_t prepared;
+	uint8_t rsp[SE050_SIM_APDU_MAX];
+	uint32_t rspLen;
+} i2cmArg_t;
+
+static const uint8_t reg = 0x00;
+
+/*
+ * Batch of sensor reads: register pointer write then 2-byte read.
+ */
+static void setBatch(i2cmArg_t *i2cm, uint32_t batch) {
+	memset(i2cm->tlv, 0, sizeof(i2cm->tlv));
+	for (uint32_t k = 0; k < batch; k++) {
+		i2cm->tlv[2 * k].tag = SE050_TAG_I2CM_Write;
+		i2cm->tlv[2 * k].cmd.p_data = (uint8_t*) &reg;
+		i2cm->tlv[2 * k].cmd.len = 1;
+		i2cm->tlv[2 * k + 1].tag = SE050_TAG_I2CM_Read;
+		i2cm->tlv[2 * k + 1].cmd.len = 2;
+	}
+	i2cm->sz_tlv = 2 * batch;
+}
+
+/*
+ * Simulated SE050 handler answering attested I2CM commands as the SE050
+ * does, with constant attestation fields. Other APDUs are echoed.
+ */
+static uint32_t attestedHandler(const uint8_t *cmd, uint32_t cmdLen,
+		uint8_t *rsp, void *arg) {
+	static const uint8_t field[72] = { 0 };
+	uint8_t rsps[SE050_SIM_APDU_MAX];
+	uint32_t n = 0;
+	uint32_t i, end, len;
+	se050_tlvWriter_t w;
+
+	if (cmdLen < 8 || cmd[1] != (SE050_INS_CRYPTO | SE050_INS_ATTEST)
+			|| cmd[3] != SE050_P2_I2CM)
+		return se050_sim_echo(cmd, cmdLen, rsp, arg);
+
+	/* BER length of TAG_1, after an extended or short Lc */
+	i = (cmd[4] == 0x00) ? 8 : 6;
+	len = cmd[i++];
+	if (len == 0x81) {
+		len = cmd[i++];
+	} else if (len == 0x82) {
+		len = cmd[i] << 8 | cmd[i + 1];
+		i += 2;
+	}
+	end = i + len;
+	while (i + 3 <= end) {
+		len = cmd[i + 1] << 8 | cmd[i + 2];
+		rsps[n++] = cmd[i];
+		rsps[n++] = 0x5A;	/* I2CM success */
+		if (cmd[i] == SE050_TAG_I2CM_Read) {
+			uint32_t rd = cmd[i + 3] << 8 | cmd[i + 4];
+			rsps[n++] = rd >> 8;
+			rsps[n++] = rd & 0xFF;
+			memset(&rsps[n], 0x11, rd);
+			n += rd;
+		}
+		i += 3 + len;
+	}
+
+	se050_tlv_initWriter(&w, rsp, SE050_SIM_APDU_MAX - 2);
+	se050_tlv_putArray(&w, SE050_TAG_1, rsps, n);
+	se050_tlv_putArray(&w, SE050_TAG_3, field, 12);
+	se050_tlv_putArray(&w, SE050_TAG_4, field, 16);
+	se050_tlv_putArray(&w, SE050_TAG_5, field, 18);
+	se050_tlv_putArray(&w, SE050_TAG_6, field, 72);
+	if (!se050_tlv_finish(&w, &len))
+		return 0;
+	rsp[len] = 0x90;
+	rsp[len + 1] = 0x00;
+	return len + 2;
+}
+
+static void runEncode(void *arg, uint32_t iterations) {
+	i2cmArg_t *i2cm = arg;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		se050_i2cm_prepare(&i2cm->prepared, i2cm->tlv, i2cm->sz_tlv,
+				SE050_AttestationAlgo_EC_SHA_256, &ctx);
+}
+
+static void runDecode(void *arg, uint32_t iterations) {
+	i2cmArg_t *i2cm = arg;
+	se050_tlvView_t view;
+	phNxpEse_data value;
+	uint32_t acc = 0, offset;
+
+	for (uint32_t k = 0; k < iterations; k++) {
+		se050_tlv_decode(&view, i2cm->rsp, i2cm->rspLen);
+		for (int tag = SE050_TAG_3; tag <= SE050_TAG_6; tag++)
+			if (se050_tlv_get(&view, (SE050_TAG_t) tag, &value))
+				acc += value.len;
+		offset = 0;
+		if (!se050_tlv_get(&view, SE050_TAG_1, &value)
+				|| se050_i2cm_getRsps(i2cm->tlv, i2cm->sz_tlv, &value, &offset)
+						!= APDU_OK) {
+			fprintf(stderr, "I2CM responses do not parse\n");
+			exit(1);
+		}
+	}
+	sink = acc;
+}
+
+static void runAttested(void *arg, uint32_t iterations) {
+	i2cmArg_t *i2cm = arg;
+	const uint8_t random[16] = { 0 };
+	attestation_t attestation;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		if (se050_i2cm_issue(&i2cm->prepared, random, &attestation, &ctx)
+				!= APDU_OK) {
+			fprintf(stderr, "attested I2CM command failed\n");
+			exit(1);
+		}
+}
+
+static void benchI2cm(void) {
+	static const uint32_t batches[] = { 1, 4, 16, MAX_BATCH };
+	static i2cmArg_t i2cm;
+	result_t result;
+	uint32_t f;
+
+	sim.handler = attestedHandler;
+	for (uint32_t k = 0; k < sizeof(batches) / sizeof(batches[0]); k++) {
+		setBatch(&i2cm, batches[k]);
+		if (se050_i2cm_prepare(&i2cm.prepared, i2cm.tlv, i2cm.sz_tlv,
+				SE050_AttestationAlgo_EC_SHA_256, &ctx) != APDU_OK) {
+			fprintf(stderr, "batch of %u reads does not fit\n", batches[k]);
+			exit(1);
+		}
+		i2cm.rspLen = attestedHandler(i2cm.prepared.apdu, i2cm.prepared.len,
+				i2cm.rsp, NULL) - 2;
+
+		if (selected("tlv_encode")) {
+			measure(runEncode, &i2cm, &result);
+			printf("{\"bench\":\"tlv_encode\",\"batch\":%u,\"bytes\":%u,",
+					batches[k], i2cm.prepared.len);
+			printResult(&result);
+			printf("}\n");
+		}
+		if (selected("tlv_decode")) {
+			measure(runDecode, &i2cm, &result);
+			printf("{\"bench\":\"tlv_decode\",\"batch\":%u,\"bytes\":%u,",
+					batches[k], i2cm.rspLen);
+			printResult(&result);
+			printf("}\n");
+		}
+		if (selected("attested")) {
+			f = frames();
+			runAttested(&i2cm, 1);
+			f = frames() - f;
+			measure(runAttested, &i2cm, &result);
+			printf("{\"bench\":\"attested\",\"batch\":%u,\"frames\":%u,",
+					batches[k], f);
+			printResult(&result);
+			printf("}\n");
+		}
+	}
+	sim.handler = se050_sim_echo;
+}
+
+/*
+ * APDU round trips
+ */
+static const uint8_t header[] = { 0x80, 0x04, 0x00, 0x00 };
+
+static void runApdu(void *arg, uint32_t iterations) {
+	uint32_t len = *(uint32_t*) arg;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		if (se050_sendCommand(header, len, 0, &ctx) != APDU_OK) {
+			fprintf(stderr, "APDU round trip failed\n");
+			exit(1);
+		}
+}
+
+static void benchChain(void) {
+	static const uint8_t ifsc[] = { 32, 64, 128, 254 };
+	uint32_t len = APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2 - 32;
+	result_t result;
+	uint32_t f;
+
+	for (uint32_t k = 0; k < sizeof(ifsc); k++) {
+		sim.ifsc = ifsc[k];
+		phNxpEse_setIfsc(ifsc[k]);
+		f = frames();
+		runApdu(&len, 1);
+		f = frames() - f;
+		measure(runApdu, &len, &result);
+		printf("{\"bench\":\"chain\",\"ifsc\":%u,\"len\":%u,\"frames\":%u,",
+				ifsc[k], len, f);
+		printResult(&result);
+		/* command and echoed response */
+		printf(",\"mb_per_s\":%.2f}\n", 2 * len * 1e3 / result.nsPerOp);
+	}
+	sim.ifsc = 254;
+	phNxpEse_setIfsc(254);
+}
+
+/*
+ * Binary objects
+ */
+typedef struct {
+	uint16_t len;
+	uint8_t data[SE050_SIM_STORE_OBJECT_SIZE];
+	uint8_t read[SE050_SIM_STORE_OBJECT_SIZE];
+} objectArg_t;
+
+static uint32_t objectSource(uint8_t *buff, uint32_t len, uint32_t offset,
+		void *arg) {
+	objectArg_t *object = arg;
+
+	memcpy(buff, &object->data[offset], len);
+	return len;
+}
+
+static apdu_status_t objectSink(const uint8_t *buff, uint32_t len,
+		uint32_t offset, void *arg) {
+	objectArg_t *object = arg;
+
+	memcpy(&object->read[offset], buff, len);
+	return APDU_OK;
+}
+
+static void runWrite(void *arg, uint32_t iterations) {
+	objectArg_t *object = arg;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		if (se050_writeBinaryStream(OBJECT_ID, object->len, objectSource,
+				object, &ctx) != APDU_OK) {
+			fprintf(stderr, "object write failed\n");
+			exit(1);
+		}
+}
+
+static void runRead(void *arg, uint32_t iterations) {
+	objectArg_t *object = arg;
+
+	for (uint32_t k = 0; k < iterations; k++)
+		if (se050_readObjectStream(OBJECT_ID, object->len, objectSink, object,
+				&ctx) != APDU_OK) {
+			fprintf(stderr, "object read failed\n");
+			exit(1);
+		}
+}
+
+static void benchObject(void) {
+	static const uint16_t lens[] = { 256, 1024, SE050_SIM_STORE_OBJECT_SIZE };
+	static se050_simStore_t store;
+	static objectArg_t object;
+	static const struct {
+		const char *op;
+		benchFn_t fn;
+	} ops[] = { { "write", runWrite }, { "read", runRead } };
+	result_t result;
+	uint32_t apdus, f;
+
+	se050_sim_storeInit(&store);
+	sim.handler = se050_sim_store;
+	sim.arg = &store;
+	for (uint32_t k = 0; k < sizeof(object.data); k++)
+		object.data[k] = k * 7;
+	for (uint32_t k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+		object.len = lens[k];
+		for (uint32_t op = 0; op < sizeof(ops) / sizeof(ops[0]); op++) {
+			apdus = sim.apdus;
+			f = frames();
+			ops[op].fn(&object, 1);
+			apdus = sim.apdus - apdus;
+			f = frames() - f;
+			if (ops[op].fn == runRead
+					&& memcmp(object.read, object.data, object.len) != 0) {
+				fprintf(stderr, "object read back differs\n");
+				exit(1);
+			}
+			measure(ops[op].fn, &object, &result);
+			printf("{\"bench\":\"object\",\"op\":\"%s\",\"len\":%u,"
+					"\"apdus\":%u,\"frames\":%u,", ops[op].op, object.len,
+					apdus, f);
+			printResult(&result);
+			printf(",\"kb_per_s\":%.1f}\n", object.len * 1e6 / result.nsPerOp);
+		}
+	}
+	sim.handler = se050_sim_echo;
+	sim.arg = NULL;
+}
+
+static void benchLatency(void) {
+	static const uint32_t latencies[] = { 0, 500, 2000, 10000 };
+	static double us[MAX_ROUND_TRIPS];
+	uint32_t len = 32;
+	phNxpEse_stats_t before, after;
+	double sum;
+	uint64_t t;
+
+	realDelays = 1;
+	for (uint32_t k = 0; k < sizeof(latencies) / sizeof(latencies[0]); k++) {
+		sim.latencyUs = latencies[k];
+		phNxpEse_getStats(&before);
+		sum = 0;
+		for (uint32_t n = 0; n < roundTrips; n++) {
+			t = nowNs();
+			runApdu(&len, 1);
+			us[n] = (nowNs() - t) / 1e3;
+			sum += us[n];
+		}
+		phNxpEse_getStats(&after);
+		qsort(us, roundTrips, sizeof(us[0]), compare);
+		printf("{\"bench\":\"latency\",\"latency_us\":%u,\"len\":%u,"
+				"\"round_trips\":%u,\"us_mean\":%.1f,\"us_min\":%.1f,"
+				"\"us_median\":%.1f,\"us_max\":%.1f,\"polls_per_op\":%.2f}\n",
+				latencies[k], len, roundTrips, sum / roundTrips, us[0],
+				us[roundTrips / 2], us[roundTrips - 1],
+				(double) (after.nadPolls - before.nadPolls) / roundTrips);
+	}
+	sim.latencyUs = 0;
+	realDelays = 0;
+}
+
+/*
+ * Command pipelines
+ */
+#define PIPE_CMD_LEN	64
+
+typedef struct {
+	/// Host processing time of the encoding and of the parsing of a command
+	uint32_t workUs;
+	/// Responses checked
+	uint32_t parsed;
+} pipeArg_t;
+
+/*
+ * Stand-in for the host processing of a command, e.g. computing a digest.
+ */
+static void work(uint32_t us) {
+	uint64_t end = nowNs() + us * 1000ull;
+
+	while (nowNs() < end)
+		;
+}
+
+static apdu_status_t pipeEncode(uint32_t index, uint8_t *header,
+		uint8_t *data, uint32_t *len, uint32_t *le, void *arg) {
+	pipeArg_t *pipe = arg;
+
+	if (*len < PIPE_CMD_LEN)
+		return APDU_ERROR;
+	work(pipe->workUs);
+	header[0] = 0x80;
+	header[1] = SE050_INS_MGMT;
+	header[2] = SE050_P1_DEFAULT;
+	header[3] = SE050_P2_DEFAULT;
+	memset(data, index, PIPE_CMD_LEN);
+	*len = PIPE_CMD_LEN;
+	*le = 0;
+	return APDU_OK;
+}
+
+static apdu_status_t pipeParse(uint32_t index, const phNxpEse_data *rsp,
+		uint16_t sw, void *arg) {
+	pipeArg_t *pipe = arg;
+
+	work(pipe->workUs);
+	/* the echoed command: header and short Lc, then data */
+	if (sw != 0x9000 || rsp->len < 5 + PIPE_CMD_LEN
+			|| rsp->p_data[5] != (uint8_t) index)
+		return APDU_ERROR;
+	pipe->parsed++;
+	return APDU_OK;
+}
+
+static void runSerial(pipeArg_t *pipe) {
+	uint8_t header[4];
+	uint32_t len, le;
+
+	for (uint32_t k = 0; k < roundTrips; k++) {
+		len = APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2;
+		if (pipeEncode(k, header, &ctx.buff[APDU_HDR_MAX_SZ], &len, &le, pipe)
+				!= APDU_OK
+				|| se050_sendCommand(header, len, le, &ctx) != APDU_OK
+				|| pipeParse(k, &ctx.out, ctx.sw, pipe) != APDU_OK) {
+			fprintf(stderr, "serial command failed\n");
+			exit(1);
+		}
+	}
+}
+
+static void benchPipeline(void) {
+	static const uint32_t works[] = { 0, 500, 1000, 2000 };
+	static se050_pipeline_t pipeline;
+	pipeArg_t pipe;
+	double serialUs, pipelinedUs;
+	uint64_t t;
+
+	realDelays = 1;
+	sim.latencyUs = 2000;
+	for (uint32_t k = 0; k < sizeof(works) / sizeof(works[0]); k++) {
+		pipe.workUs = works[k];
+		pipe.parsed = 0;
+		t = nowNs();
+		runSerial(&pipe);
+		serialUs = (nowNs() - t) / 1e3 / roundTrips;
+
+		t = nowNs();
+		if (se050_pipeline_run(&pipeline, roundTrips, pipeEncode, pipeParse,
+				&pipe, &ctx) != APDU_OK || pipe.parsed != 2 * roundTrips) {
+			fprintf(stderr, "pipelined command failed\n");
+			exit(1);
+		}
+		pipelinedUs = (nowNs() - t) / 1e3 / roundTrips;
+
+		printf("{\"bench\":\"pipeline\",\"latency_us\":%u,\"work_us\":%u,"
+				"\"commands\":%u,\"serial_us_per_cmd\":%.1f,"
+				"\"pipelined_us_per_cmd\":%.1f,\"speedup\":%.2f,"
+				"\"overlapped\":%u,\"serial\":%u}\n", sim.latencyUs,
+				works[k], roundTrips, serialUs, pipelinedUs,
+				serialUs / pipelinedUs, pipeline.overlapped, pipeline.serial);
+		fflush(stdout);
+	}
+	sim.latencyUs = 0;
+	realDelays = 0;
+}
+
+/*
+ * Worker priorities
+ */
+static se050_future_t background[MBED_CONF_SE050_WORKER_QUEUE_DEPTH];
+
+static apdu_status_t streamJob(apdu_ctx_t *ctx, void *arg) {
+	objectArg_t *object = arg;
+
+	return se050_writeBinaryStream(OBJECT_ID, object->len, objectSource,
+			object, ctx);
+}
+
+/*
+ * Keep the low priority queue full of object streams, so that the worker is
+ * never idle.
+ */
+static void feedBackground(objectArg_t *object) {
+	for (uint32_t k = 0; k < MBED_CONF_SE050_WORKER_QUEUE_DEPTH; k++) {
+		if (background[k].state != SE050_FUTURE_IDLE) {
+			if (!se050_future_done(&background[k]))
+				continue;
+			if (background[k].status != APDU_OK) {
+				fprintf(stderr, "background job failed\n");
+				exit(1);
+			}
+		}
+		if (se050_worker_submit(&background[k], SE050_PRIO_LOW, streamJob,
+				object) != APDU_OK) {
+			fprintf(stderr, "cannot submit the background job\n");
+			exit(1);
+		}
+	}
+}
+
+static apdu_status_t urgentJob(apdu_ctx_t *ctx, void *arg) {
+	uint16_t size;
+
+	return se050_readSize(OBJECT_ID, &size, ctx);
+}
+
+/*
+ * Time high priority requests submitted at random times, with or without a
+ * saturating background stream.
+ */
+static void runWorker(const char *load, objectArg_t *object, double chunkUs) {
+	static double us[MAX_ROUND_TRIPS];
+	se050_queueStats_t stats;
+	struct timespec pause;
+	double sum = 0;
+	uint64_t t;
+
+	se050_worker_resetStats();
+	for (uint32_t n = 0; n < roundTrips; n++) {
+		if (object != NULL)
+			feedBackground(object);
+		/* land at a random point of the background APDUs */
+		pause.tv_sec = 0;
+		pause.tv_nsec = (rand() % 5000) * 1000L;
+		nanosleep(&pause, NULL);
+		t = nowNs();
+		if (se050_worker_call(SE050_PRIO_HIGH, urgentJob, NULL) != APDU_OK) {
+			fprintf(stderr, "high priority request failed\n");
+			exit(1);
+		}
+		us[n] = (nowNs() - t) / 1e3;
+		sum += us[n];
+	}
+	se050_worker_getStats(SE050_PRIO_HIGH, &stats);
+	for (uint32_t k = 0; k < MBED_CONF_SE050_WORKER_QUEUE_DEPTH; k++)
+		if (background[k].state != SE050_FUTURE_IDLE)
+			se050_future_wait(&background[k]);
+
+	qsort(us, roundTrips, sizeof(us[0]), compare);
+	printf("{\"bench\":\"worker\",\"load\":\"%s\",\"latency_us\":%u,"
+			"\"chunk_us\":%.1f,\"round_trips\":%u,\"us_mean\":%.1f,"
+			"\"us_median\":%.1f,\"us_max\":%.1f,\"preemptions\":%u}\n",
+			load, WORKER_LATENCY_US, chunkUs, roundTrips, sum / roundTrips,
+			us[roundTrips / 2], us[roundTrips - 1], stats.preemptions);
+	fflush(stdout);
+}
+
+/*
+ * Must run last: the worker owns the APDU context once started.
+ */
+static void benchWorker(void) {
+	static se050_simStore_t store;
+	static objectArg_t object;
+	double chunkUs = 0;
+	uint64_t t;
+
+	realDelays = 1;
+	se050_sim_storeInit(&store);
+	sim.handler = se050_sim_store;
+	sim.arg = &store;
+	sim.latencyUs = WORKER_LATENCY_US;
+	object.len = SE050_SIM_STORE_OBJECT_SIZE;
+	runWrite(&object, 1);
+
+	/* round trip of a single background APDU */
+	for (uint32_t n = 0; n < roundTrips; n++) {
+		t = nowNs();
+		if (se050_writeBinary(OBJECT_ID, 0, 0, object.data,
+				SE050_OBJ_WRITE_CHUNK_SZ, &ctx) != APDU_OK) {
+			fprintf(stderr, "object write failed\n");
+			exit(1);
+		}
+		chunkUs += (nowNs() - t) / 1e3;
+	}
+	chunkUs /= roundTrips;
+
+	if (se050_worker_start(&ctx) != APDU_OK) {
+		fprintf(stderr, "cannot start the worker\n");
+		exit(1);
+	}
+	runWorker("none", NULL, chunkUs);
+	runWorker("stream", &object, chunkUs);
+	/* the worker yield hook cannot be installed again */
+	se050_setYieldHook(NULL, NULL);
+	runWorker("stream_no_yield", &object, chunkUs);
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-b bench] [-s samples] [-t sample_ms] "
+			"[-n round_trips]\n", name);
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:s:t:n:")) != -1) {
+		switch (opt) {
+		case 'b':
+			filter = optarg;
+			break;
+		case 's':
+			samples = atoi(optarg);
+			break;
+		case 't':
+			sampleMs = atoi(optarg);
+			break;
+		case 'n':
+			roundTrips = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (samples < 1 || samples > MAX_SAMPLES || roundTrips < 1
+			|| roundTrips > MAX_ROUND_TRIPS)
+		usage(argv[0]);
+
+	se050_sim_init(&sim);
+	se050_sim_attach(&sim);
+	se050_initApduCtx(&ctx);
+	if (se050_connect(&ctx) != APDU_OK) {
+		fprintf(stderr, "cannot connect to the simulated SE050\n");
+		return 1;
+	}
+
+	printf("{\"bench\":\"config\",\"format\":1,\"samples\":%u,"
+			"\"sample_ms\":%u,\"round_trips\":%u}\n", samples, sampleMs,
+			roundTrips);
+	if (selected("crc"))
+		benchCrc();
+	if (selected("tlv_encode") || selected("tlv_decode")
+			|| selected("attested"))
+		benchI2cm();
+	if (selected("chain"))
+		benchChain();
+	if (selected("object"))
+		benchObject();
+	if (selected("latency"))
+		benchLatency();
+	if (selected("pipeline"))
+		benchPipeline();
+	if (selected("worker"))
+		benchWorker();
+
+	se050_disconnect(&ctx);
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The protocol layer is built here so that its frame CRC, which is static,
+ * can be benchmarked.
+ */
+
+#include "phNxpEseProto7816_3.c"
+
+uint16_t bench_crc(uint8_t *data, uint32_t len) {
+	return phNxpEseProto7816_ComputeCRC(data, 0, len);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host check of the C++ command descriptors of se050_commands.hpp.
+ *
+ * Every descriptor is instantiated, so that its worst-case size checks are
+ * evaluated by the compiler. The read commands are then sent to the simulated
+ * SE050 object store of tools/sim and their results compared with the ones of
+ * the C API of apdu.h. Built with -DCOMMANDS_OVERFLOW, a descriptor whose data
+ * do not fit in the APDU buffer is added and the build must fail (see the
+ * check-overflow target of the Makefile).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "se050_commands.hpp"
+extern "C" {
+#include "se050_sim.h"
+#include "se050_sim_store.h"
+}
+
+using namespace se050;
+
+/* instantiate all descriptors, evaluating their static_asserts */
+static_assert(sizeof(cmd::ReadType) > 0, "");
+static_assert(sizeof(cmd::ReadSize) > 0, "");
+static_assert(sizeof(cmd::CheckObjectExists) > 0, "");
+static_assert(sizeof(cmd::ReadIDList) > 0, "");
+static_assert(sizeof(cmd::GetRandom) > 0, "");
+static_assert(sizeof(cmd::MACOneShot) > 0, "");
+
+static_assert(cmd::ReadType::header[1] == SE050_INS_READ
+		&& cmd::ReadType::header[3] == SE050_P2_TYPE, "ReadType header");
+static_assert(cmd::ReadSize::le == tlvLen(2), "ReadSize Le");
+
+#ifdef COMMANDS_OVERFLOW
+typedef Command<SE050_INS_WRITE, SE050_P1_BINARY, SE050_P2_DEFAULT,
+		Layout<Tlv<SE050_TAG_1, 4>, Tlv<SE050_TAG_4, APDU_BUFF_SZ> >,
+		Layout<> > TooLarge;
+static_assert(sizeof(TooLarge) > 0, "");
+#endif
+
+#define OBJ_ID		0x7FFF0201
+#define OBJ_SIZE	300
+
+static se050_sim_t sim;
+static se050_simStore_t store;
+static apdu_ctx_t ctx;
+static int failures;
+
+/* host platform, polling delays are skipped */
+extern "C" {
+
+void thread_sleep_for(uint32_t millisec) {
+}
+
+void wait_ms(int ms) {
+}
+
+uint32_t se050_timer_us(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+}
+
+static void check(const char *name, bool ok) {
+	printf("%-26s %s\n", name, ok ? "ok" : "FAILED");
+	if (!ok)
+		failures++;
+}
+
+static apdu_status_t readType(uint32_t objId, uint8_t *type) {
+	Encoder<cmd::ReadType> enc(&ctx);
+	Decoder<cmd::ReadType> dec;
+
+	enc.put<0>(objId);
+	if (enc.send(&ctx) != APDU_OK || dec.parse(&ctx) != APDU_OK)
+		return APDU_ERROR;
+	return dec.get<0>(type);
+}
+
+static apdu_status_t readSize(uint32_t objId, uint16_t *size) {
+	Encoder<cmd::ReadSize> enc(&ctx);
+	Decoder<cmd::ReadSize> dec;
+	phNxpEse_data value;
+
+	enc.put<0>(objId);
+	if (enc.send(&ctx) != APDU_OK || dec.parse(&ctx) != APDU_OK
+			|| dec.get<0>(&value) != APDU_OK || value.len != 2)
+		return APDU_ERROR;
+	*size = value.p_data[0] << 8 | value.p_data[1];
+	return APDU_OK;
+}
+
+static apdu_status_t checkObjectExists(uint32_t objId, bool *exists) {
+	Encoder<cmd::CheckObjectExists> enc(&ctx);
+	Decoder<cmd::CheckObjectExists> dec;
+	uint8_t result;
+
+	enc.put<0>(objId);
+	if (enc.send(&ctx) != APDU_OK || dec.parse(&ctx) != APDU_OK
+			|| dec.get<0>(&result) != APDU_OK)
+		return APDU_ERROR;
+	*exists = (result == SE050_Result_SUCCESS);
+	return APDU_OK;
+}
+
+int main(void) {
+	static uint8_t data[OBJ_SIZE];
+	uint8_t type, cType;
+	uint16_t size, cSize;
+	bool exists, cExists;
+
+	se050_sim_init(&sim);
+	se050_sim_storeInit(&store);
+	sim.handler = se050_sim_store;
+	sim.arg = &store;
+	se050_sim_attach(&sim);
+	se050_initApduCtx(&ctx);
+	if (se050_connect(&ctx) != APDU_OK) {
+		fprintf(stderr, "cannot connect to the simulated SE050\n");
+		return 1;
+	}
+
+	check("CheckObjectExists absent",
+			checkObjectExists(OBJ_ID, &exists) == APDU_OK && !exists);
+
+	memset(data, 0xA5, sizeof(data));
+	if (se050_writeBinary(OBJ_ID, 0, OBJ_SIZE, data, sizeof(data), &ctx)
+			!= APDU_OK) {
+		fprintf(stderr, "cannot write the test object\n");
+		return 1;
+	}
+
+	check("CheckObjectExists", checkObjectExists(OBJ_ID, &exists) == APDU_OK
+			&& se050_checkObjectExists(OBJ_ID, &cExists, &ctx) == APDU_OK
+			&& exists && exists == cExists);
+	check("ReadType", readType(OBJ_ID, &type) == APDU_OK
+			&& se050_readType(OBJ_ID, &cType, &ctx) == APDU_OK
+			&& type == cType);
+	check("ReadSize", readSize(OBJ_ID, &size) == APDU_OK
+			&& se050_readSize(OBJ_ID, &cSize, &ctx) == APDU_OK
+			&& size == cSize && size == OBJ_SIZE);
+	check("ReadSize not found", readSize(OBJ_ID + 1, &size) != APDU_OK);
+
+	se050_disconnect(&ctx);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Recovery time of the T1oI2C stack per transport fault.
+ *
+ * Each scenario injects a fault in the simulated SE050 of tools/sim (bit
+ * flips, lost frames, NACKed addresses, delayed responses, spurious WTX)
+ * while a chained APDU is exchanged, and measures the round trip with real
+ * polling and recovery delays. The recovery time is the median round trip
+ * minus the fault free one. Failed APDUs are followed by a reconnection,
+ * whose time is reported apart.
+ *
+ * Each result is printed as a JSON object on its own line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "apdu.h"
+#include "phNxpEse_Api.h"
+#include "phNxpEsePal_i2c.h"
+#include "phNxpEseProto7816_3.h"
+#include "se050_sim.h"
+#include "platform/timer.h"
+
+#define MAX_TRIALS	100
+
+typedef struct {
+	const char *name;
+	se050_simFault_t fault;
+	uint32_t skip;
+	uint32_t count;
+} scenario_t;
+
+/*
+ * With the default APDU length, the command and the response are both
+ * chained over two frames.
+ */
+static const scenario_t scenarios[] = {
+	{ "none", SE050_SIM_FAULT_NONE, 0, 0 },
+	{ "bitflip", SE050_SIM_FAULT_BITFLIP, 0, 1 },
+	{ "bitflip", SE050_SIM_FAULT_BITFLIP, 1, 1 },
+	{ "bitflip", SE050_SIM_FAULT_BITFLIP, 0, 2 },
+	{ "bitflip", SE050_SIM_FAULT_BITFLIP, 0, 3 },
+	{ "drop", SE050_SIM_FAULT_DROP, 0, 1 },
+	{ "drop", SE050_SIM_FAULT_DROP, 1, 1 },
+	{ "nack", SE050_SIM_FAULT_NACK, 0, 1 },
+	{ "nack", SE050_SIM_FAULT_NACK, 0, 3 },
+	{ "nack", SE050_SIM_FAULT_NACK, 0, 4 },
+	{ "nack", SE050_SIM_FAULT_NACK, 2, 4 },
+	{ "delay", SE050_SIM_FAULT_DELAY, 0, 10000 },
+	{ "delay", SE050_SIM_FAULT_DELAY, 0, 100000 },
+	{ "delay", SE050_SIM_FAULT_DELAY, 0, 2000000 },
+	{ "wtx", SE050_SIM_FAULT_WTX, 0, 1 },
+	{ "wtx", SE050_SIM_FAULT_WTX, 0, 10 },
+};
+
+static uint32_t trials = 5;
+static uint32_t apduLen = 300;
+static const char *filter;
+
+static se050_sim_t sim;
+static apdu_ctx_t ctx;
+static uint8_t expected[APDU_BUFF_SZ];
+static uint32_t expectedLen;
+
+static uint64_t nowNs(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void thread_sleep_for(uint32_t millisec) {
+	struct timespec ts = { millisec / 1000, (millisec % 1000) * 1000000L };
+
+	nanosleep(&ts, NULL);
+}
+
+void wait_ms(int ms) {
+	thread_sleep_for(ms);
+}
+
+uint32_t se050_timer_us(void) {
+	return nowNs() / 1000;
+}
+
+static int compare(const void *a, const void *b) {
+	double x = *(const double*) a;
+	double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Exchange the echoed APDU, returns true if the response is the expected
+ * one.
+ */
+static int exchange(void) {
+	static const uint8_t header[] = { 0x80, 0x04, 0x00, 0x00 };
+
+	for (uint32_t k = 0; k < apduLen; k++)
+		ctx.buff[APDU_HDR_MAX_SZ + k] = k;
+	if (se050_sendCommand(header, apduLen, 0, &ctx) != APDU_OK)
+		return 0;
+	if (expectedLen == 0) {
+		memcpy(expected, ctx.out.p_data, ctx.out.len);
+		expectedLen = ctx.out.len;
+	}
+	return ctx.out.len == expectedLen
+			&& memcmp(ctx.out.p_data, expected, expectedLen) == 0;
+}
+
+static int reconnect(void) {
+	se050_disconnect(&ctx);
+	return se050_connect(&ctx) == APDU_OK;
+}
+
+static void run(const scenario_t *scenario, double *baseline) {
+	static double us[MAX_TRIALS];
+	phNxpEse_stats_t before, after;
+	uint32_t ok = 0, n = 0;
+	double reconnectUs = 0;
+	uint64_t t;
+
+	phNxpEse_getStats(&before);
+	for (uint32_t k = 0; k < trials; k++) {
+		se050_sim_inject(&sim, scenario->fault, scenario->skip,
+				scenario->count);
+		t = nowNs();
+		if (exchange()) {
+			us[n++] = (nowNs() - t) / 1e3;
+			ok++;
+		} else {
+			se050_sim_inject(&sim, SE050_SIM_FAULT_NONE, 0, 0);
+			t = nowNs();
+			if (!reconnect()) {
+				fprintf(stderr, "%s: cannot reconnect\n", scenario->name);
+				exit(1);
+			}
+			reconnectUs += (nowNs() - t) / 1e3;
+		}
+	}
+	phNxpEse_getStats(&after);
+	se050_sim_inject(&sim, SE050_SIM_FAULT_NONE, 0, 0);
+
+	printf("{\"fault\":\"%s\",\"skip\":%u,\"count\":%u,\"trials\":%u,"
+			"\"ok\":%u,", scenario->name, scenario->skip, scenario->count,
+			trials, ok);
+	if (n > 0) {
+		qsort(us, n, sizeof(us[0]), compare);
+		if (scenario->fault == SE050_SIM_FAULT_NONE)
+			*baseline = us[n / 2];
+		printf("\"us_median\":%.1f,\"us_max\":%.1f,\"recovery_us\":%.1f,",
+				us[n / 2], us[n - 1], us[n / 2] - *baseline);
+	}
+	if (ok < trials)
+		printf("\"reconnect_us\":%.1f,", reconnectUs / (trials - ok));
+	printf("\"retransmissions\":%u,\"rnack_sent\":%u,"
+			"\"rnack_received\":%u,\"crc_errors\":%u,\"wtx\":%u,"
+			"\"resyncs\":%u,\"intf_resets\":%u,\"nad_polls\":%u}\n",
+			after.retransmissions - before.retransmissions,
+			after.rnackSent - before.rnackSent,
+			after.rnackReceived - before.rnackReceived,
+			after.crcErrors - before.crcErrors, after.wtx - before.wtx,
+			after.resyncs - before.resyncs,
+			after.intfResets - before.intfResets,
+			after.nadPolls - before.nadPolls);
+	fflush(stdout);
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "usage: %s [-f fault] [-n trials] [-l apdu_len]\n", name);
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	double baseline = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:n:l:")) != -1) {
+		switch (opt) {
+		case 'f':
+			filter = optarg;
+			break;
+		case 'n':
+			trials = atoi(optarg);
+			break;
+		case 'l':
+			apduLen = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (trials < 1 || trials > MAX_TRIALS || apduLen < 1
+			|| apduLen > APDU_BUFF_SZ - APDU_HDR_MAX_SZ - 2 - 32)
+		usage(argv[0]);
+
+	se050_sim_init(&sim);
+	se050_sim_attach(&sim);
+	se050_initApduCtx(&ctx);
+	if (se050_connect(&ctx) != APDU_OK || !exchange()) {
+		fprintf(stderr, "cannot exchange with the simulated SE050\n");
+		return 1;
+	}
+
+	printf("{\"fault\":\"config\",\"trials\":%u,\"apdu_len\":%u,\"ifsc\":%u,"
+			"\"poll_delay_ms\":%u,\"nad_polling_max\":%u,"
+			"\"delay_error_recovery\":%u,\"frame_retry_count\":%u,"
+			"\"rnack_retry_limit\":%u,\"wtx_default_count\":%u}\n", trials,
+			apduLen, sim.ifsc, ESE_POLL_DELAY_MS, ESE_NAD_POLLING_MAX,
+			DELAY_ERROR_RECOVERY, PH_PROTO_7816_FRAME_RETRY_COUNT,
+			MAX_RNACK_RETRY_LIMIT, PH_PROTO_WTX_DEFAULT_COUNT);
+	for (uint32_t k = 0; k < sizeof(scenarios) / sizeof(scenarios[0]); k++)
+		if (k == 0 || filter == NULL
+				|| strcmp(filter, scenarios[k].name) == 0)
+			run(&scenarios[k], &baseline);
+
+	se050_disconnect(&ctx);
+	return 0;
+}
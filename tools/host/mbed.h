@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host replacements of the mbed RTOS classes used by platform/worker.cpp,
+ * built on POSIX threads. Thread priorities and stack sizes are ignored.
+ */
+
+#ifndef TOOLS_HOST_MBED_H_
+#define TOOLS_HOST_MBED_H_
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+typedef enum {
+	osOK = 0,
+	osError = -1
+} osStatus;
+
+typedef enum {
+	osPriorityNormal = 24,
+	osPriorityAboveNormal = 32
+} osPriority;
+
+typedef pthread_t osThreadId;
+
+typedef void (*Callback)(void);
+
+static inline Callback callback(void (*fn)(void)) {
+	return fn;
+}
+
+class Mutex {
+public:
+	Mutex() {
+		pthread_mutex_init(&_mutex, NULL);
+	}
+	void lock() {
+		pthread_mutex_lock(&_mutex);
+	}
+	void unlock() {
+		pthread_mutex_unlock(&_mutex);
+	}
+
+private:
+	friend class ConditionVariable;
+	pthread_mutex_t _mutex;
+};
+
+class ConditionVariable {
+public:
+	ConditionVariable(Mutex &mutex) :
+			_mutex(mutex) {
+		pthread_condattr_t attr;
+
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&_cond, &attr);
+		pthread_condattr_destroy(&attr);
+	}
+	void wait() {
+		pthread_cond_wait(&_cond, &_mutex._mutex);
+	}
+	/* returns true on timeout */
+	bool wait_for(uint32_t millisec) {
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		ts.tv_sec += millisec / 1000;
+		ts.tv_nsec += (millisec % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+		return pthread_cond_timedwait(&_cond, &_mutex._mutex, &ts) == ETIMEDOUT;
+	}
+	void notify_one() {
+		pthread_cond_signal(&_cond);
+	}
+	void notify_all() {
+		pthread_cond_broadcast(&_cond);
+	}
+
+private:
+	Mutex &_mutex;
+	pthread_cond_t _cond;
+};
+
+class Thread {
+public:
+	Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = 0,
+			unsigned char *stack_mem = NULL, const char *name = NULL) :
+			_task(NULL), _thread() {
+	}
+	osStatus start(Callback task) {
+		_task = task;
+		return (pthread_create(&_thread, NULL, run, this) == 0) ? osOK : osError;
+	}
+	osThreadId get_id() const {
+		return _thread;
+	}
+
+private:
+	static void *run(void *arg) {
+		static_cast<Thread*>(arg)->_task();
+		return NULL;
+	}
+	Callback _task;
+	pthread_t _thread;
+};
+
+namespace ThisThread {
+static inline osThreadId get_id() {
+	return pthread_self();
+}
+}
+
+#endif /* TOOLS_HOST_MBED_H_ */
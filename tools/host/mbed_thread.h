@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host replacements of the mbed APIs used by the T1oI2C stack. Each tool
+ * provides the delays: the replayer runs on the virtual clock of the
+ * capture, benchmarks sleep for real when timing matters.
+ */
+
+#ifndef TOOLS_HOST_MBED_THREAD_H_
+#define TOOLS_HOST_MBED_THREAD_H_
+
+#include <stdint.h>
+
+void thread_sleep_for(uint32_t millisec);
+
+#endif /* TOOLS_HOST_MBED_THREAD_H_ */
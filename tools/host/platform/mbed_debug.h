@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TOOLS_HOST_MBED_DEBUG_H_
+#define TOOLS_HOST_MBED_DEBUG_H_
+
+#include <stdio.h>
+#include <errno.h>
+
+#define debug(...) fprintf(stderr, __VA_ARGS__)
+
+void wait_ms(int ms);
+
+#endif /* TOOLS_HOST_MBED_DEBUG_H_ */
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replay a T=1 capture (see T1oI2C/capture.h) through the protocol stack.
+ *
+ * The capture is cut into steps: session initializations (interface reset
+ * requests), APDUs (reassembled from host I-frames) and end of sessions.
+ * Each step is run through the phNxpEse API, on top of an I2C layer which
+ * checks every written frame against the capture and serves captured SE050
+ * frames to reads. Replay stops at the first divergence, so a field capture
+ * reproduces the exact frame sequence, retries included, on a host.
+ *
+ * The time of each step is taken from the capture time stamps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phNxpEse_Api.h"
+#include "phNxpEseProto7816_3.h"
+#include "capture.h"
+#include "../../platform/i2c.h"
+#include "../../platform/timer.h"
+
+typedef struct {
+	uint32_t timestamp;
+	uint8_t dir;
+	uint16_t len;
+	const uint8_t *frame;
+} record_t;
+
+typedef enum {
+	STEP_INIT,
+	STEP_APDU,
+	STEP_EOS
+} stepKind_t;
+
+typedef struct {
+	stepKind_t kind;
+	/// Index of the first record of the step
+	uint32_t first;
+	/// Reassembled APDU
+	uint8_t *apdu;
+	uint32_t apduLen;
+} step_t;
+
+static record_t *records;
+static uint32_t nRecords;
+/// Next record expected on the bus
+static uint32_t cursor;
+/// Number of bytes of the current SE050 frame already read
+static uint32_t rxOffset;
+/// Number of reads answered with a NACK
+static uint32_t nacks;
+
+static void dump(const char *label, const uint8_t *data, uint32_t len) {
+	fprintf(stderr, "%s:", label);
+	for (uint32_t k = 0; k < len; k++)
+		fprintf(stderr, " %02X", data[k]);
+	fprintf(stderr, "\n");
+}
+
+static void diverge(const char *what, const uint8_t *data, uint32_t len) {
+	fprintf(stderr, "divergence at record %u: %s\n", cursor, what);
+	if (data != NULL)
+		dump("  replay ", data, len);
+	if (cursor < nRecords)
+		dump("  capture", records[cursor].frame, records[cursor].len);
+	exit(2);
+}
+
+/*
+ * Host I2C layer backed by the capture.
+ */
+i2c_error_t axI2CInit(void) {
+	return I2C_OK;
+}
+
+i2c_error_t axI2CClose(void) {
+	return I2C_OK;
+}
+
+i2c_error_t axI2CWrite(unsigned char bus, unsigned char addr,
+		unsigned char *pTx, unsigned short txLen) {
+
+	if (cursor >= nRecords)
+		diverge("write after the end of the capture", pTx, txLen);
+	if (records[cursor].dir != SE050_CAPTURE_TX || rxOffset != 0)
+		diverge("write while the SE050 has a frame to send", pTx, txLen);
+	if (records[cursor].len != txLen
+			|| memcmp(records[cursor].frame, pTx, txLen) != 0)
+		diverge("frame differs", pTx, txLen);
+	cursor++;
+	return I2C_OK;
+}
+
+i2c_error_t axI2CRead(unsigned char bus, unsigned char addr,
+		unsigned char *pRx, unsigned short rxLen) {
+
+	if (cursor >= nRecords || records[cursor].dir != SE050_CAPTURE_RX) {
+		/* the SE050 has nothing to send */
+		nacks++;
+		return I2C_NACK_ON_ADDRESS;
+	}
+	if (rxOffset + rxLen > records[cursor].len)
+		diverge("read past the end of the SE050 frame", NULL, 0);
+	memcpy(pRx, &records[cursor].frame[rxOffset], rxLen);
+	rxOffset += rxLen;
+	if (rxOffset == records[cursor].len) {
+		rxOffset = 0;
+		cursor++;
+	}
+	return I2C_OK;
+}
+
+void thread_sleep_for(uint32_t millisec) {
+}
+
+void wait_ms(int ms) {
+}
+
+uint32_t se050_timer_us(void) {
+	return records[(cursor < nRecords) ? cursor : nRecords - 1].timestamp;
+}
+
+static uint8_t *load(const char *path, uint32_t *len) {
+	FILE *f = fopen(path, "rb");
+	uint8_t *data;
+	long size;
+
+	if (f == NULL)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	data = malloc(size);
+	if (data == NULL || fread(data, 1, size, f) != (size_t) size) {
+		fclose(f);
+		free(data);
+		return NULL;
+	}
+	fclose(f);
+	*len = size;
+	return data;
+}
+
+static int parse(const uint8_t *data, uint32_t len) {
+	uint32_t offset = SE050_CAPTURE_FILE_HDR_LEN;
+
+	if (len < SE050_CAPTURE_FILE_HDR_LEN || memcmp(data, "S05C", 4) != 0
+			|| data[4] != SE050_CAPTURE_VERSION)
+		return -1;
+
+	records = malloc(sizeof(record_t) * (len / SE050_CAPTURE_RECORD_HDR_LEN));
+	while (offset + SE050_CAPTURE_RECORD_HDR_LEN <= len) {
+		const uint8_t *p = &data[offset];
+		record_t *r = &records[nRecords];
+
+		r->timestamp = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+		r->dir = p[4];
+		r->len = p[6] | (p[7] << 8);
+		r->frame = &p[SE050_CAPTURE_RECORD_HDR_LEN];
+		offset += SE050_CAPTURE_RECORD_HDR_LEN + r->len;
+		if (offset > len || r->len < PH_PROTO_7816_HEADER_LEN + PH_PROTO_7816_CRC_LEN)
+			return -1;
+		nRecords++;
+	}
+	return (offset == len) ? 0 : -1;
+}
+
+/*
+ * Cut the capture into steps. I-frames identical to the previous one are
+ * retransmissions, other host frames are generated by the stack itself.
+ */
+static step_t *plan(uint32_t *nSteps) {
+	step_t *steps = calloc(nRecords + 1, sizeof(step_t));
+	const record_t *lastIframe = NULL;
+	step_t *apdu = NULL;
+
+	*nSteps = 0;
+	for (uint32_t k = 0; k < nRecords; k++) {
+		const record_t *r = &records[k];
+		uint8_t pcb = r->frame[PH_PROPTO_7816_PCB_OFFSET];
+		uint8_t infLen = r->frame[PH_PROPTO_7816_LEN_UPPER_OFFSET];
+
+		if (r->dir != SE050_CAPTURE_TX)
+			continue;
+
+		if ((pcb & 0x80) == 0) {
+			if (lastIframe != NULL && lastIframe->len == r->len
+					&& memcmp(lastIframe->frame, r->frame, r->len) == 0)
+				continue;
+			lastIframe = r;
+			if (apdu == NULL) {
+				apdu = &steps[(*nSteps)++];
+				apdu->kind = STEP_APDU;
+				apdu->first = k;
+			}
+			apdu->apdu = realloc(apdu->apdu, apdu->apduLen + infLen);
+			memcpy(&apdu->apdu[apdu->apduLen],
+					&r->frame[PH_PROPTO_7816_INF_BYTE_OFFSET], infLen);
+			apdu->apduLen += infLen;
+			if ((pcb & PH_PROTO_7816_CHAINING) == 0)
+				apdu = NULL;
+		} else if (apdu == NULL && (pcb & 0xE0) == PH_PROTO_7816_S_BLOCK_REQ) {
+			if ((pcb & 0x1F) == PH_PROTO_7816_S_RESET) {
+				steps[*nSteps].kind = STEP_INIT;
+				steps[(*nSteps)++].first = k;
+				lastIframe = NULL;
+			} else if ((pcb & 0x1F) == PH_PROTO_7816_S_END_OF_APDU) {
+				steps[*nSteps].kind = STEP_EOS;
+				steps[(*nSteps)++].first = k;
+			}
+		}
+	}
+	return steps;
+}
+
+static ESESTATUS run(const step_t *step, int opened) {
+	static uint8_t rsp[0x10000];
+	phNxpEse_initParams initParams = { .initMode = ESE_MODE_NORMAL };
+	phNxpEse_data cmdData = { step->apduLen, step->apdu };
+	phNxpEse_data rspData = { sizeof(rsp), rsp };
+	ESESTATUS status;
+
+	switch (step->kind) {
+	case STEP_INIT:
+		if (opened)
+			phNxpEse_close();
+		status = phNxpEse_open(initParams);
+		if (status != ESESTATUS_SUCCESS)
+			return status;
+		return phNxpEse_init(initParams, &rspData);
+	case STEP_APDU:
+		return phNxpEse_Transceive(&cmdData, &rspData);
+	default:
+		return phNxpEse_EndOfApdu();
+	}
+}
+
+int main(int argc, char **argv) {
+	static const char *kinds[] = { "init", "apdu", "eos" };
+	uint32_t len, nSteps;
+	uint8_t *data;
+	step_t *steps;
+	phNxpEse_stats_t stats;
+	int opened = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s capture.bin\n", argv[0]);
+		return 1;
+	}
+	data = load(argv[1], &len);
+	if (data == NULL || parse(data, len) != 0 || nRecords == 0) {
+		fprintf(stderr, "%s: not a valid capture\n", argv[1]);
+		return 1;
+	}
+	steps = plan(&nSteps);
+	if (nSteps == 0 || steps[0].kind != STEP_INIT) {
+		fprintf(stderr, "capture must start with a session initialization\n");
+		return 1;
+	}
+
+	printf("step  kind  first  frames  time_us  status\n");
+	for (uint32_t s = 0; s < nSteps; s++) {
+		uint32_t first = cursor;
+		ESESTATUS status = run(&steps[s], opened);
+		uint32_t last = (cursor > first) ? cursor - 1 : first;
+
+		opened = 1;
+		printf("%4u  %-4s  %5u  %6u  %7u  0x%02X\n", s, kinds[steps[s].kind],
+				first, cursor - first,
+				records[last].timestamp - records[first].timestamp, status);
+	}
+	if (cursor != nRecords) {
+		fprintf(stderr, "%u records of the capture were not replayed\n",
+				nRecords - cursor);
+		return 2;
+	}
+
+	phNxpEse_getStats(&stats);
+	printf("\n%u records replayed, %u NACKed reads\n", nRecords, nacks);
+	printf("frames sent %u received %u, retransmissions %u, R-NACK sent %u received %u,"
+			" CRC errors %u, WTX %u (max %u)\n", stats.framesSent,
+			stats.framesReceived, stats.retransmissions, stats.rnackSent,
+			stats.rnackReceived, stats.crcErrors, stats.wtx, stats.wtxMax);
+	printf("capture span %u us\n",
+			records[nRecords - 1].timestamp - records[0].timestamp);
+	return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_sim.h"
+#include <string.h>
+#include "platform/i2c.h"
+#include "platform/timer.h"
+
+#define NAD_SE		0xA5
+#define PCB_S		0xC0
+#define PCB_S_RSP	0x20
+#define PCB_R		0x80
+#define PCB_SEQ		0x40
+#define PCB_MORE	0x20
+
+#define S_RESYNCH	0x00
+#define S_WTX		0x03
+#define S_INTF_RESET	0x0F
+
+static const uint8_t atr[] = { 0x00, 0xA0, 0x00, 0x00, 0x03, 0x96, 0x04, 0x03,
+		0xE8, 0x00, 0xFE, 0x02, 0x0B, 0x03, 0xE8, 0x08, 0x01, 0x00, 0x00,
+		0x00, 0x00, 0x64, 0x00, 0x00, 0x0A, 0x4A, 0x43, 0x4F, 0x50, 0x34,
+		0x20, 0x41, 0x54, 0x50, 0x4F };
+
+static se050_sim_t *current;
+
+static uint16_t crc(const uint8_t *data, uint32_t len) {
+	uint16_t crc = 0xFFFF;
+	for (uint32_t k = 0; k < len; k++) {
+		crc ^= data[k];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+	}
+	return crc ^ 0xFFFF;
+}
+
+/*
+ * Returns true if fault occurs at this event, once faultSkip events went
+ * through.
+ */
+static bool due(se050_sim_t *sim, se050_simFault_t fault) {
+	if (sim->fault != fault)
+		return false;
+	if (sim->faultSkip > 0) {
+		sim->faultSkip--;
+		return false;
+	}
+	sim->faults++;
+	return true;
+}
+
+/*
+ * Account for one occurrence of a repeated fault.
+ */
+static void consume(se050_sim_t *sim) {
+	if (--sim->faultCount == 0)
+		sim->fault = SE050_SIM_FAULT_NONE;
+}
+
+static void sendFrame(se050_sim_t *sim, uint8_t pcb, const uint8_t *inf,
+		uint32_t len) {
+	uint16_t c;
+
+	sim->frame[0] = NAD_SE;
+	sim->frame[1] = pcb;
+	sim->frame[2] = len;
+	if (len > 0)
+		memcpy(&sim->frame[3], inf, len);
+	c = crc(sim->frame, 3 + len);
+	sim->frame[3 + len] = c & 0xFF;
+	sim->frame[4 + len] = c >> 8;
+	sim->frameLen = 5 + len;
+	sim->frameOffset = 0;
+	sim->framesOut++;
+	sim->corruptAt = 0;
+	if (due(sim, SE050_SIM_FAULT_BITFLIP)) {
+		/* first information byte, or CRC if there is none */
+		sim->corruptAt = (len > 0) ? 3 : 4;
+		consume(sim);
+	}
+}
+
+static void sendWtx(se050_sim_t *sim) {
+	const uint8_t multiplier = 1;
+
+	sendFrame(sim, PCB_S | S_WTX, &multiplier, 1);
+}
+
+static void sendChunk(se050_sim_t *sim) {
+	uint32_t len = sim->rspLen - sim->rspOffset;
+	uint8_t pcb = sim->seq ? PCB_SEQ : 0;
+
+	if (len > sim->ifsc) {
+		len = sim->ifsc;
+		pcb |= PCB_MORE;
+	}
+	sendFrame(sim, pcb, &sim->rsp[sim->rspOffset], len);
+	sim->rspOffset += len;
+	sim->seq ^= 1;
+}
+
+static void onSFrame(se050_sim_t *sim, uint8_t type) {
+	if (type & PCB_S_RSP) {
+		/* WTX response: request the next extension or answer */
+		if (sim->wtx > 0 && --sim->wtx > 0)
+			sendWtx(sim);
+		else if (sim->rspOffset == 0 && sim->rspLen > 0)
+			sendChunk(sim);
+		return;
+	}
+	switch (type) {
+	case S_INTF_RESET:
+		sim->cmdLen = 0;
+		sim->rspLen = sim->rspOffset = 0;
+		sim->seq = sim->hostSeq = 0;
+		sim->wtx = 0;
+		sim->busy = false;
+		sendFrame(sim, PCB_S | PCB_S_RSP | type, atr, sizeof(atr));
+		break;
+	case S_RESYNCH:
+		sim->seq = sim->hostSeq = 0;
+		/* fall through */
+	default:
+		sendFrame(sim, PCB_S | PCB_S_RSP | type, NULL, 0);
+		break;
+	}
+}
+
+static void onIFrame(se050_sim_t *sim, uint8_t pcb, const uint8_t *inf,
+		uint32_t len) {
+	if (((pcb & PCB_SEQ) ? 1 : 0) != sim->hostSeq) {
+		/* our acknowledgment was lost: send it again */
+		sim->frameOffset = 0;
+		return;
+	}
+	sim->hostSeq ^= 1;
+	if (sim->cmdLen + len > sizeof(sim->cmd))
+		len = sizeof(sim->cmd) - sim->cmdLen;
+	memcpy(&sim->cmd[sim->cmdLen], inf, len);
+	sim->cmdLen += len;
+	if (pcb & PCB_MORE) {
+		sendFrame(sim, PCB_R | (sim->hostSeq << 4), NULL, 0);
+		return;
+	}
+	sim->rspLen = sim->handler(sim->cmd, sim->cmdLen, sim->rsp, sim->arg);
+	sim->rspOffset = 0;
+	sim->cmdLen = 0;
+	sim->apdus++;
+	sim->busy = true;
+	sim->readyAt = se050_timer_us() + sim->latencyUs;
+	if (due(sim, SE050_SIM_FAULT_DELAY)) {
+		sim->readyAt += sim->faultCount;
+		sim->fault = SE050_SIM_FAULT_NONE;
+	}
+	if (due(sim, SE050_SIM_FAULT_WTX)) {
+		sim->wtx = sim->faultCount;
+		sim->fault = SE050_SIM_FAULT_NONE;
+		sendWtx(sim);
+		return;
+	}
+	sendChunk(sim);
+}
+
+static void onRFrame(se050_sim_t *sim, uint8_t pcb) {
+	if ((pcb & 0x0F) == 0 && sim->rspOffset < sim->rspLen)
+		sendChunk(sim);
+	else
+		/* error or nothing left to send: repeat the last frame */
+		sim->frameOffset = 0;
+}
+
+void se050_sim_init(se050_sim_t *sim) {
+	memset(sim, 0, sizeof(*sim));
+	sim->ifsc = 254;
+	sim->handler = se050_sim_echo;
+}
+
+void se050_sim_attach(se050_sim_t *sim) {
+	current = sim;
+}
+
+void se050_sim_inject(se050_sim_t *sim, se050_simFault_t fault, uint32_t skip,
+		uint32_t count) {
+	sim->fault = (count > 0) ? fault : SE050_SIM_FAULT_NONE;
+	sim->faultSkip = skip;
+	sim->faultCount = count;
+}
+
+uint32_t se050_sim_echo(const uint8_t *cmd, uint32_t cmdLen, uint8_t *rsp,
+		void *arg) {
+	if (cmdLen > SE050_SIM_APDU_MAX - 2)
+		cmdLen = SE050_SIM_APDU_MAX - 2;
+	memcpy(rsp, cmd, cmdLen);
+	rsp[cmdLen] = 0x90;
+	rsp[cmdLen + 1] = 0x00;
+	return cmdLen + 2;
+}
+
+/*
+ * I2C layer
+ */
+i2c_error_t axI2CInit(void) {
+	return I2C_OK;
+}
+
+i2c_error_t axI2CClose(void) {
+	return I2C_OK;
+}
+
+i2c_error_t axI2CWrite(unsigned char bus, unsigned char addr,
+		unsigned char *pTx, unsigned short txLen) {
+	se050_sim_t *sim = current;
+	uint8_t pcb;
+
+	if (due(sim, SE050_SIM_FAULT_NACK)) {
+		consume(sim);
+		return I2C_NACK_ON_ADDRESS;
+	}
+	sim->framesIn++;
+	if (due(sim, SE050_SIM_FAULT_DROP)) {
+		consume(sim);
+		return I2C_OK;
+	}
+	if (txLen < 5 || pTx[2] != txLen - 5
+			|| crc(pTx, txLen - 2) != (pTx[txLen - 2] | pTx[txLen - 1] << 8)) {
+		/* EDC error */
+		sendFrame(sim, PCB_R | (sim->hostSeq << 4) | 0x01, NULL, 0);
+		return I2C_OK;
+	}
+	pcb = pTx[1];
+	if ((pcb & PCB_S) == PCB_S)
+		onSFrame(sim, pcb & 0x3F);
+	else if (pcb & PCB_R)
+		onRFrame(sim, pcb);
+	else
+		onIFrame(sim, pcb, &pTx[3], pTx[2]);
+	return I2C_OK;
+}
+
+i2c_error_t axI2CRead(unsigned char bus, unsigned char addr,
+		unsigned char *pRx, unsigned short rxLen) {
+	se050_sim_t *sim = current;
+	uint32_t len;
+
+	if (sim->busy && (int32_t) (se050_timer_us() - sim->readyAt) >= 0)
+		sim->busy = false;
+	if (sim->frameOffset >= sim->frameLen || sim->busy) {
+		sim->polls++;
+		return I2C_NACK_ON_ADDRESS;
+	}
+	if (due(sim, SE050_SIM_FAULT_NACK)) {
+		consume(sim);
+		return I2C_NACK_ON_ADDRESS;
+	}
+	len = sim->frameLen - sim->frameOffset;
+	if (len > rxLen)
+		len = rxLen;
+	memcpy(pRx, &sim->frame[sim->frameOffset], len);
+	memset(&pRx[len], 0, rxLen - len);
+	if (sim->corruptAt != 0 && sim->corruptAt >= sim->frameOffset
+			&& sim->corruptAt < sim->frameOffset + len)
+		pRx[sim->corruptAt - sim->frameOffset] ^= 0x01;
+	sim->frameOffset += len;
+	if (sim->frameOffset == sim->frameLen)
+		/* a repeated frame is sent intact */
+		sim->corruptAt = 0;
+	return I2C_OK;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Simulated SE050 for host tools. It implements the I2C layer of
+ * platform/i2c.h and speaks T=1 over I2C (UM1225) to the T1oI2C stack:
+ * interface reset, I-frame chaining in both directions, R-frames and end of
+ * apdu session. APDUs are answered by a handler.
+ *
+ * The SE050 is busy (reads are NACKed) for latencyUs after the last frame of
+ * an APDU, measured with se050_timer_us().
+ *
+ * Transport faults can be injected to exercise the recovery paths of the
+ * stack, see se050_sim_inject().
+ */
+
+#ifndef TOOLS_SIM_SE050_SIM_H_
+#define TOOLS_SIM_SE050_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SE050_SIM_APDU_MAX	1024
+
+/*
+ * Answer the APDU cmd (cmdLen bytes). The response, status word included,
+ * is written to rsp (SE050_SIM_APDU_MAX bytes). Returns the response length.
+ */
+typedef uint32_t (*se050_simHandler_t)(const uint8_t *cmd, uint32_t cmdLen,
+		uint8_t *rsp, void *arg);
+
+/**
+ * Transport faults.
+ */
+typedef enum {
+	SE050_SIM_FAULT_NONE,
+	/// Flip a bit of count frames sent by the SE050
+	SE050_SIM_FAULT_BITFLIP,
+	/// Lose count frames written by the host
+	SE050_SIM_FAULT_DROP,
+	/// Do not acknowledge the address of count I2C transfers
+	SE050_SIM_FAULT_NACK,
+	/// Add count microseconds to the processing time of an APDU
+	SE050_SIM_FAULT_DELAY,
+	/// Request count waiting time extensions before answering an APDU
+	SE050_SIM_FAULT_WTX
+} se050_simFault_t;
+
+typedef struct {
+	/// Largest information field of frames sent by the SE050 (1 to 254)
+	uint8_t ifsc;
+	/// Processing time of an APDU, in microseconds
+	uint32_t latencyUs;
+	/// APDU handler, se050_sim_echo() by default
+	se050_simHandler_t handler;
+	void *arg;
+
+	/// Frames written by the host
+	uint32_t framesIn;
+	/// Frames sent to the host
+	uint32_t framesOut;
+	/// Reads NACKed while the SE050 was busy or had nothing to send
+	uint32_t polls;
+	/// APDUs answered
+	uint32_t apdus;
+	/// Faults injected
+	uint32_t faults;
+
+	/* pending fault */
+	se050_simFault_t fault;
+	uint32_t faultSkip;
+	uint32_t faultCount;
+
+	/* protocol state */
+	uint8_t frame[3 + 254 + 2];
+	uint32_t frameLen;
+	uint32_t frameOffset;
+	uint8_t seq;
+	uint8_t hostSeq;
+	uint8_t cmd[SE050_SIM_APDU_MAX];
+	uint32_t cmdLen;
+	uint8_t rsp[SE050_SIM_APDU_MAX];
+	uint32_t rspLen;
+	uint32_t rspOffset;
+	bool busy;
+	uint32_t readyAt;
+	/// Offset of the flipped byte of the frame being read, 0 if none
+	uint32_t corruptAt;
+	/// Waiting time extensions left to request
+	uint32_t wtx;
+} se050_sim_t;
+
+/**
+ * Initialize a simulated SE050 with an IFSC of 254, no latency and the echo
+ * handler.
+ */
+void se050_sim_init(se050_sim_t *sim);
+
+/**
+ * Route the I2C layer to sim.
+ */
+void se050_sim_attach(se050_sim_t *sim);
+
+/**
+ * Inject a fault. Frames, transfers or APDUs (depending on the fault) are
+ * let through before the fault occurs, so that it can hit a given frame of a
+ * chain. A new fault replaces a pending one.
+ * @param sim Pointer to a simulated SE050
+ * @param fault Fault, SE050_SIM_FAULT_NONE to cancel a pending fault
+ * @param skip Number of frames, transfers or APDUs let through
+ * @param count Number of faulty frames or transfers, delay in microseconds or number of WTX requests
+ */
+void se050_sim_inject(se050_sim_t *sim, se050_simFault_t fault, uint32_t skip,
+		uint32_t count);
+
+/**
+ * Handler answering the command APDU followed by 9000.
+ */
+uint32_t se050_sim_echo(const uint8_t *cmd, uint32_t cmdLen, uint8_t *rsp,
+		void *arg);
+
+#endif /* TOOLS_SIM_SE050_SIM_H_ */
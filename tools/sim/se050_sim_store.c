@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "se050_sim_store.h"
+#include <string.h>
+#include "se050_sim.h"
+#include "apdu.h"
+#include "se050_tlv.h"
+
+#define SW_OK			0x9000
+#define SW_WRONG_DATA		0x6A80
+#define SW_NOT_FOUND		0x6A82
+#define SW_NO_SPACE		0x6A84
+#define SW_WRONG_LENGTH		0x6700
+
+static uint32_t getUint(const phNxpEse_data *value) {
+	uint32_t n = 0;
+
+	for (uint32_t k = 0; k < value->len; k++)
+		n = n << 8 | value->p_data[k];
+	return n;
+}
+
+static se050_simObject_t* find(se050_simStore_t *store, uint32_t id) {
+	for (uint32_t k = 0; k < SE050_SIM_STORE_OBJECTS; k++)
+		if (store->objects[k].used && store->objects[k].id == id)
+			return &store->objects[k];
+	return NULL;
+}
+
+static se050_simObject_t* create(se050_simStore_t *store, uint32_t id) {
+	for (uint32_t k = 0; k < SE050_SIM_STORE_OBJECTS; k++)
+		if (!store->objects[k].used) {
+			store->objects[k].used = true;
+			store->objects[k].id = id;
+			return &store->objects[k];
+		}
+	return NULL;
+}
+
+static uint32_t status(uint8_t *rsp, uint32_t len, uint16_t sw) {
+	rsp[len] = sw >> 8;
+	rsp[len + 1] = sw & 0xFF;
+	return len + 2;
+}
+
+static uint32_t writeBinary(se050_simStore_t *store,
+		const se050_tlvView_t *view, uint8_t *rsp) {
+	phNxpEse_data id, offset, fileLen, data;
+	se050_simObject_t *obj;
+	uint32_t off;
+
+	if (!se050_tlv_get(view, SE050_TAG_1, &id)
+			|| !se050_tlv_get(view, SE050_TAG_4, &data))
+		return status(rsp, 0, SW_WRONG_DATA);
+	off = se050_tlv_get(view, SE050_TAG_2, &offset) ? getUint(&offset) : 0;
+	obj = find(store, getUint(&id));
+	if (se050_tlv_get(view, SE050_TAG_3, &fileLen)) {
+		/* creation */
+		if (obj == NULL)
+			obj = create(store, getUint(&id));
+		if (obj == NULL || getUint(&fileLen) > SE050_SIM_STORE_OBJECT_SIZE)
+			return status(rsp, 0, SW_NO_SPACE);
+		obj->type = SE050_SecureObjectType_BINARY_FILE;
+		obj->len = getUint(&fileLen);
+		memset(obj->data, 0, obj->len);
+	}
+	if (obj == NULL)
+		return status(rsp, 0, SW_NOT_FOUND);
+	if (off + data.len > obj->len)
+		return status(rsp, 0, SW_WRONG_LENGTH);
+	memcpy(&obj->data[off], data.p_data, data.len);
+	return status(rsp, 0, SW_OK);
+}
+
+static uint32_t readObject(se050_simStore_t *store, const se050_tlvView_t *view,
+		uint8_t *rsp) {
+	phNxpEse_data id, offset, length;
+	se050_simObject_t *obj;
+	se050_tlvWriter_t w;
+	uint32_t off = 0, len, rspLen;
+
+	if (!se050_tlv_get(view, SE050_TAG_1, &id))
+		return status(rsp, 0, SW_WRONG_DATA);
+	obj = find(store, getUint(&id));
+	if (obj == NULL)
+		return status(rsp, 0, SW_NOT_FOUND);
+	len = obj->len;
+	if (se050_tlv_get(view, SE050_TAG_2, &offset))
+		off = getUint(&offset);
+	if (se050_tlv_get(view, SE050_TAG_3, &length))
+		len = getUint(&length);
+	if (off + len > obj->len)
+		return status(rsp, 0, SW_WRONG_LENGTH);
+
+	se050_tlv_initWriter(&w, rsp, SE050_SIM_APDU_MAX - 2);
+	se050_tlv_putArray(&w, SE050_TAG_1, &obj->data[off], len);
+	if (!se050_tlv_finish(&w, &rspLen))
+		return status(rsp, 0, SW_WRONG_LENGTH);
+	return status(rsp, rspLen, SW_OK);
+}
+
+static uint32_t readAttribute(se050_simStore_t *store, uint8_t p2,
+		const se050_tlvView_t *view, uint8_t *rsp) {
+	phNxpEse_data id;
+	se050_simObject_t *obj;
+	se050_tlvWriter_t w;
+	uint32_t rspLen;
+
+	if (!se050_tlv_get(view, SE050_TAG_1, &id))
+		return status(rsp, 0, SW_WRONG_DATA);
+	obj = find(store, getUint(&id));
+	se050_tlv_initWriter(&w, rsp, SE050_SIM_APDU_MAX - 2);
+	if (p2 == SE050_P2_EXIST)
+		se050_tlv_putU8(&w, SE050_TAG_1,
+				(obj != NULL) ? SE050_Result_SUCCESS : SE050_Result_FAILURE);
+	else if (obj == NULL)
+		return status(rsp, 0, SW_NOT_FOUND);
+	else if (p2 == SE050_P2_SIZE)
+		se050_tlv_putU16(&w, SE050_TAG_1, obj->len);
+	else
+		se050_tlv_putU8(&w, SE050_TAG_1, obj->type);
+	se050_tlv_finish(&w, &rspLen);
+	return status(rsp, rspLen, SW_OK);
+}
+
+static uint32_t deleteObject(se050_simStore_t *store,
+		const se050_tlvView_t *view, uint8_t *rsp) {
+	phNxpEse_data id;
+	se050_simObject_t *obj;
+
+	if (!se050_tlv_get(view, SE050_TAG_1, &id))
+		return status(rsp, 0, SW_WRONG_DATA);
+	obj = find(store, getUint(&id));
+	if (obj == NULL)
+		return status(rsp, 0, SW_NOT_FOUND);
+	obj->used = false;
+	return status(rsp, 0, SW_OK);
+}
+
+void se050_sim_storeInit(se050_simStore_t *store) {
+	memset(store, 0, sizeof(*store));
+}
+
+uint32_t se050_sim_store(const uint8_t *cmd, uint32_t cmdLen, uint8_t *rsp,
+		void *arg) {
+	se050_simStore_t *store = arg;
+	uint8_t data[SE050_SIM_APDU_MAX];
+	se050_tlvView_t view;
+	uint32_t i, len;
+
+	if (cmdLen < 5)
+		return se050_sim_echo(cmd, cmdLen, rsp, arg);
+
+	/* body after an extended or short Lc, up to Le */
+	if (cmd[4] == 0x00 && cmdLen >= 7) {
+		len = cmd[5] << 8 | cmd[6];
+		i = 7;
+	} else {
+		len = cmd[4];
+		i = 5;
+	}
+	if (i + len > cmdLen)
+		return status(rsp, 0, SW_WRONG_LENGTH);
+	memcpy(data, &cmd[i], len);
+	if (!se050_tlv_decode(&view, data, len))
+		return se050_sim_echo(cmd, cmdLen, rsp, arg);
+
+	if (cmd[1] == SE050_INS_WRITE && cmd[2] == SE050_P1_BINARY)
+		len = writeBinary(store, &view, rsp);
+	else if (cmd[1] == SE050_INS_READ && cmd[3] == SE050_P2_DEFAULT)
+		len = readObject(store, &view, rsp);
+	else if ((cmd[1] == SE050_INS_READ
+			&& (cmd[3] == SE050_P2_SIZE || cmd[3] == SE050_P2_TYPE))
+			|| (cmd[1] == SE050_INS_MGMT && cmd[3] == SE050_P2_EXIST))
+		len = readAttribute(store, cmd[3], &view, rsp);
+	else if (cmd[1] == SE050_INS_MGMT && cmd[3] == SE050_P2_DELETE_OBJECT)
+		len = deleteObject(store, &view, rsp);
+	else
+		return se050_sim_echo(cmd, cmdLen, rsp, arg);
+	store->commands++;
+	return len;
+}
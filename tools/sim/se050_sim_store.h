@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020, Michael Grand
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Secure object store of the simulated SE050: binary objects written with
+ * WriteBinary and read back with ReadObject, ReadSize, ReadType,
+ * CheckObjectExists and DeleteSecureObject. Other APDUs are echoed.
+ */
+
+#ifndef TOOLS_SIM_SE050_SIM_STORE_H_
+#define TOOLS_SIM_SE050_SIM_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SE050_SIM_STORE_OBJECTS		8
+#define SE050_SIM_STORE_OBJECT_SIZE	4096
+
+typedef struct {
+	bool used;
+	uint32_t id;
+	uint8_t type;
+	uint16_t len;
+	uint8_t data[SE050_SIM_STORE_OBJECT_SIZE];
+} se050_simObject_t;
+
+typedef struct {
+	se050_simObject_t objects[SE050_SIM_STORE_OBJECTS];
+	/// Commands answered by the store
+	uint32_t commands;
+} se050_simStore_t;
+
+/**
+ * Initialize an empty store.
+ */
+void se050_sim_storeInit(se050_simStore_t *store);
+
+/**
+ * Handler of the simulated SE050 (see se050_simHandler_t), arg points to
+ * the store.
+ */
+uint32_t se050_sim_store(const uint8_t *cmd, uint32_t cmdLen, uint8_t *rsp,
+		void *arg);
+
+#endif /* TOOLS_SIM_SE050_SIM_STORE_H_ */